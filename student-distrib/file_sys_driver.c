@@ -2,12 +2,89 @@
 #include "terminal_driver.h"
 #include "pcb.h"
 #include "rtc.h"
+#include "pseudo_fs.h"
+#include "pipe.h"
 
 static int dentry_num;      // Total number of directory entries
 static int inode_num;       // Total number of index nodes
 static int d_block_num;     // Total number of data block numbers
 static uint32_t dir_idx;    // Current directory index for dir_read
 
+// Name index built at init_fs: open-addressed hash over the fixed-width names.
+// Each slot holds dentry index + 1, 0 marks an empty slot.
+static uint8_t name_index[NAME_HASH_SIZE];
+// Dentry names normalized to NAME_LEN bytes, zero padded after the first NUL
+static uint32_t name_keys[DENTRY_NUM][NAME_KEY_WORDS];
+
+/* make_name_key
+ *
+ * Normalize a file name into a fixed-width key: copy up to NAME_LEN bytes,
+ * stop at the first NUL and zero the rest.
+ * Inputs: fname -- the name to normalize, need not be NUL terminated at NAME_LEN
+ *         key -- NAME_LEN bytes of output
+ * Outputs: Return 0 for success
+ *          Return -1 if the name is empty or longer than NAME_LEN
+ * Side Effects: None
+ */
+static int32_t make_name_key(const uint8_t* fname, uint32_t* key){
+    uint8_t* key_bytes = (uint8_t*)key;
+    int32_t i;
+    memset(key, 0, NAME_LEN);
+    for (i = 0; i < NAME_LEN && fname[i] != '\0'; i++)
+        key_bytes[i] = fname[i];
+    if (i == 0) return -1;
+    return 0;
+}
+
+/* hash_name_key
+ *
+ * FNV-1a over the words of a fixed-width name key
+ * Inputs: key -- normalized name key
+ * Outputs: slot in name_index to start probing from
+ * Side Effects: None
+ */
+static uint32_t hash_name_key(const uint32_t* key){
+    uint32_t hash = FNV_OFFSET;
+    int32_t i;
+    for (i = 0; i < NAME_KEY_WORDS; i++)
+        hash = (hash ^ key[i]) * FNV_PRIME;
+    return (hash ^ (hash >> NAME_HASH_SHIFT)) & (NAME_HASH_SIZE - 1);
+}
+
+/* name_key_equal
+ *
+ * Compare two fixed-width name keys word by word
+ * Inputs: k1, k2 -- normalized name keys
+ * Outputs: 1 if equal, 0 if not
+ * Side Effects: None
+ */
+static inline int32_t name_key_equal(const uint32_t* k1, const uint32_t* k2){
+    return k1[0] == k2[0] && k1[1] == k2[1] && k1[2] == k2[2] && k1[3] == k2[3] &&
+           k1[4] == k2[4] && k1[5] == k2[5] && k1[6] == k2[6] && k1[7] == k2[7];
+}
+
+/* build_name_index
+ *
+ * Fill the name hash from the boot block's directory entries. Later entries
+ * with a name that is already indexed are skipped so the first match wins,
+ * same as the old linear scan.
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: Fill name_keys and name_index
+ */
+static void build_name_index(){
+    uint32_t index, slot;
+    memset(name_index, 0, sizeof(name_index));
+    for (index = 0; index < dentry_num; index++) {
+        // names in the image are NAME_LEN bytes and are not NUL terminated when full
+        if (make_name_key((uint8_t*)dentry_addr[index].filename, name_keys[index])) continue;
+        slot = hash_name_key(name_keys[index]);
+        while (name_index[slot] && !name_key_equal(name_keys[name_index[slot] - 1], name_keys[index]))
+            slot = (slot + 1) & (NAME_HASH_SIZE - 1);
+        if (!name_index[slot]) name_index[slot] = index + 1;
+    }
+}
+
 /* init_fs
  *
  * Initialize the file system by setting the constants
@@ -24,6 +101,8 @@ void init_fs(uint32_t fs_addr_start){
     dentry_addr = b_block_addr -> dir_entries;
     inode_start_addr = (inode_t*) &(b_block_addr[BOOT_BLOCK_NUM]);
     d_block_start_addr = (data_block_t*) &(inode_start_addr[inode_num]);
+    if (dentry_num > DENTRY_NUM) dentry_num = DENTRY_NUM;
+    build_name_index();
     init_fop_table();
 }
 
@@ -38,12 +117,13 @@ void init_fs(uint32_t fs_addr_start){
  * Side Effects: Save the value of target into dentry
  */
 int32_t read_dentry_by_index(uint32_t index, dentry_t* dentry){
-    if (index >= dentry_num) return -1;
+    // pseudo files list after the files of the image
+    if (index >= dentry_num) return pseudo_dentry_by_index(index - dentry_num, dentry);
     memcpy(dentry, &(dentry_addr[index]), DENTRY_SIZE);
     return 0;
 }
 
-/* read_dentry_by_index
+/* read_dentry_by_name
  *
  * Helper funtion that takes in inode name and saves the dentry
  * data to a in put buffer.
@@ -54,17 +134,31 @@ int32_t read_dentry_by_index(uint32_t index, dentry_t* dentry){
  * Side Effects: Save the value of target into dentry
  */
 int32_t read_dentry_by_name(const uint8_t* fname, dentry_t* dentry) {
-    int32_t index;
-    int8_t* cur_fname;
-    int32_t f_len = strlen((int8_t*) fname);
-    for (index = 0; index < inode_num; index ++){
-        cur_fname = dentry_addr[index].filename;
-        int32_t cur_len = strlen((int8_t*) cur_fname);
-        if (cur_len > NAME_LEN) cur_len = NAME_LEN;
-        int32_t len = (cur_len > f_len) ? cur_len : f_len;
+    int32_t index = lookup_dentry_index(fname);
+    if (index == -1) return pseudo_dentry_by_name(fname, dentry);
+    return read_dentry_by_index(index, dentry);
+}
 
-        if (!strncmp((int8_t*) fname, cur_fname, len))
-            return read_dentry_by_index(index, dentry); // If find the name, uses its index to call read_dentry_by_index
+/* lookup_dentry_index
+ *
+ * Find the dentry index of a file name through the name index
+ * Inputs: fname -- the name of the target file
+ * Outputs: Return the dentry index
+ *          Return -1 for cannot find the name
+ * Side Effects: None
+ */
+int32_t lookup_dentry_index(const uint8_t* fname) {
+    uint32_t key[NAME_KEY_WORDS];
+    uint32_t slot;
+    if (!fname || make_name_key(fname, key)) return -1;
+    slot = hash_name_key(key);
+    while (name_index[slot]) {
+        if (name_key_equal(name_keys[name_index[slot] - 1], key)) {
+            // a full-width match only counts if fname ends right after NAME_LEN bytes
+            if (((uint8_t*)key)[NAME_LEN - 1] != '\0' && fname[NAME_LEN] != '\0') return -1;
+            return name_index[slot] - 1;
+        }
+        slot = (slot + 1) & (NAME_HASH_SIZE - 1);
     }
     return -1;
 }
@@ -72,7 +166,8 @@ int32_t read_dentry_by_name(const uint8_t* fname, dentry_t* dentry) {
 /* read_data
  *
  * Helper funtion that reads data with specific length
- * from a file given its inode, offset.
+ * from a file given its inode, offset. Walks the file one data block
+ * at a time and copies each contiguous run with memcpy.
  * Inputs: inode -- the index for the inode
  *         offset -- the starting position in a file to read from
  *         buf -- the buffer that takes the read data out
@@ -82,22 +177,47 @@ int32_t read_dentry_by_name(const uint8_t* fname, dentry_t* dentry) {
  * Side Effects: Save the value of file into buffer
  */
 int32_t read_data (uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length){
-    if (!buf) return -1;
-    inode_t file_inode = inode_start_addr[inode];   // the target inode block
-    uint32_t file_len = file_inode.length;          // the length of file
-    uint32_t buf_idx;                               // Loop counter
-    uint32_t block_off, block_idx, data_idx;        // Several variable for index and offset
+    if (!buf || inode >= inode_num) return -1;
+    inode_t* file_inode = &inode_start_addr[inode];  // the target inode block
+    uint32_t file_len = file_inode->length;          // the length of file
+    uint32_t copied = 0;                            // bytes copied so far
+    uint32_t block_off, block_idx, data_idx, chunk; // Several variable for index and offset
     if (offset > file_len) return -1;               // offset is larger than file length, return -1
-    if ((offset + length) > file_len) length = file_len - offset; // If the file is shorter than the input length, adjust length
+    if (length > file_len - offset) length = file_len - offset; // If the file is shorter than the input length, adjust length
 
-    for (buf_idx = 0; buf_idx < length; buf_idx++) {
-        data_idx = (offset + buf_idx) % BLOCK_SIZE;     // find the offset in a data block
-        block_off = (offset + buf_idx) / BLOCK_SIZE;    // find the offset of the data block in inode
-        if (block_off >= d_block_num) return -1;        // check if the data block is in range
-        block_idx = file_inode.data_block_num[block_off];   // find the actual index of the the data block
-        buf[buf_idx] = d_block_start_addr[block_idx].data[data_idx];    // set the character to buffer
+    block_off = offset / BLOCK_SIZE;    // find the offset of the first data block in inode
+    data_idx = offset % BLOCK_SIZE;     // find the offset in that data block
+    while (copied < length) {
+        if (block_off >= DATA_B_NUM) return -1;
+        block_idx = file_inode->data_block_num[block_off];  // find the actual index of the the data block
+        if (block_idx >= d_block_num) return -1;            // check if the data block is in range
+        chunk = BLOCK_SIZE - data_idx;
+        if (chunk > length - copied) chunk = length - copied;
+        memcpy(buf + copied, &(d_block_start_addr[block_idx].data[data_idx]), chunk);
+        copied += chunk;
+        block_off++;
+        data_idx = 0;   // every block after the first is read from its start
     }
-    return buf_idx;     // return the bytes read
+    return copied;      // return the bytes read
+}
+
+/* get_data_block
+ *
+ * Find the data block holding a byte of a file, for callers that map
+ * blocks instead of copying them
+ * Inputs: inode -- the index for the inode
+ *         offset -- position in the file
+ * Outputs: Return the address of the data block
+ *          Return NULL if the offset is past the end of the file
+ * Side Effects: None
+ */
+data_block_t* get_data_block(uint32_t inode, uint32_t offset){
+    if (inode >= inode_num) return NULL;
+    inode_t* file_inode = &inode_start_addr[inode];
+    if (offset >= file_inode->length || offset / BLOCK_SIZE >= DATA_B_NUM) return NULL;
+    uint32_t block_idx = file_inode->data_block_num[offset / BLOCK_SIZE];
+    if (block_idx >= d_block_num) return NULL;
+    return &d_block_start_addr[block_idx];
 }
 
 /* dir_read
@@ -111,12 +231,15 @@ int32_t read_data (uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t lengt
  * Side Effects: Save the name of file into buffer
  */
 int32_t dir_read(int32_t fd, void* buf, int32_t nbytes){
+    if (!buf) return -1;  // if buf is null, return -1
     cli();
     dentry_t dentry;
     uint32_t ret = read_dentry_by_index(dir_idx, &dentry);      // call read_dentry_by_index to read the dentry
-    if (ret == -1) return 0;
+    if (ret == -1) {
+        sti();
+        return 0;
+    }
     dir_idx++;
-    if (!buf) return -1;  // if buf is null, return -1
     strncpy((int8_t*)buf, dentry.filename, nbytes);
     strncpy((int8_t*)(buf + NAME_LEN), (int8_t*)"\0", 1);
     int32_t len = strlen((const int8_t*)buf);
@@ -135,11 +258,11 @@ int32_t dir_read(int32_t fd, void* buf, int32_t nbytes){
  * Side Effects: Save the name of file into buffer
  */
 int32_t file_read(int32_t fd, void* buf, int32_t nbytes){
+    if (!buf) return -1;  // if buf is null, return -1
     cli();
     fd_t* fda = get_fa();
     int32_t inode_idx = fda[fd].inode_idx;
     int32_t file_idx = fda[fd].file_pos;
-    if (!buf) return -1;  // if buf is null, return -1
     
     uint32_t ret_data = read_data(inode_idx, file_idx, buf, nbytes);
     if (ret_data != -1) fda[fd].file_pos += ret_data;
@@ -206,70 +329,6 @@ int32_t file_open(const uint8_t* filename){
     return 0;
 }
 
-/* check_ececutable
- *
- * Check if a file is exectuable by checking is magic number at the beginning of the file
- * Input: fname -- File name
- * Output: Return 0 if it is executable
- *         Return -1 if it is not
- * Side Effect: None
- */
-int32_t check_executable(const uint8_t* fname) {
-    dentry_t dentry;
-    int32_t ret = read_dentry_by_name(fname, &dentry);      
-    if (ret == -1) return ret;
-    int32_t inode_idx = dentry.inode_num;
-    uint8_t magic_number1, magic_number2, magic_number3, magic_number4;        // there are four magic numbers signifying executable file
-    ret = read_data(inode_idx, 0, &magic_number1, 1) & read_data(inode_idx, 1, &magic_number2, 1) &
-          read_data(inode_idx, 2, &magic_number3, 1) & read_data(inode_idx, 3, &magic_number4, 1); // read four bytes of magic number from the beginning of the file
-    if (ret == -1) return ret;
-    // check magic number
-    if (magic_number1 != 0x7F || magic_number2 != 0x45 || magic_number3 != 0x4C || magic_number4 != 0x46) 
-        return -1;
-    return 0;
-}
-
-/* exetract_ip
- *
- * exetract the entry point for a exectuable file from the file data
- * Input: fname -- File name
- * Output: Return ip if find valid entry point
- *         Return -1 if fail
- * Side Effect: None
- */
-int32_t extract_ip(const uint8_t* fname) {
-    dentry_t dentry;
-    int32_t ret = read_dentry_by_name(fname, &dentry);
-    if (ret == -1) return ret;
-    int32_t inode_idx = dentry.inode_num;
-    uint8_t ip_bytes1, ip_bytes2, ip_bytes3, ip_bytes4;
-    ret = read_data(inode_idx, 24, &ip_bytes1, 1) & read_data(inode_idx, 25, &ip_bytes2, 1)&
-          read_data(inode_idx, 26, &ip_bytes3, 1) & read_data(inode_idx, 27, &ip_bytes4, 1); // read four bytes of virtual address of first instruction
-    if (ret == -1) return ret;
-    // assemble the instruction address
-    int32_t ip = (int32_t)ip_bytes1 + ((int32_t)ip_bytes2 << 8) + ((int32_t)ip_bytes3 << 16) + ((int32_t)ip_bytes4 << 24); 
-    return ip;
-}
-
-/* load_executable
- *
- * Load the exeutable file to virtual memory address 0x8048000
- * Input: fname -- File name
- * Output: Return 0 if success
- *         Return -1 if fail
- * Side Effect: Copy the program image to 0x8048000
- */
-int32_t load_executable(uint8_t *fname){
-    dentry_t dentry;
-    int32_t ret = read_dentry_by_name(fname, &dentry);
-    if (ret == -1) return ret;
-    int32_t inode_idx = dentry.inode_num;   
-    uint32_t file_size = inode_start_addr[inode_idx].length; //obtain the file size
-    ret = read_data(inode_idx, 0, (uint8_t*)PROG_V_ADDR, file_size); // copy the file to target loaction
-    if (ret == -1) return ret;
-    return 0;
-}
-
 /* init_fop_table
  *
  * initiate the file operation table
@@ -290,8 +349,21 @@ void init_fop_table(){
     rtc_op_table.read = rtc_read;
     rtc_op_table.write = rtc_write;
     rtc_op_table.close = rtc_close;
+    rtc_op_table.poll = rtc_poll;
+    pseudo_op_table.open = pseudo_open;
+    pseudo_op_table.read = pseudo_read;
+    pseudo_op_table.write = pseudo_write;
+    pseudo_op_table.close = pseudo_close;
+    pipe_op_table.open = pipe_open;
+    pipe_op_table.read = pipe_read;
+    pipe_op_table.write = pipe_write;
+    pipe_op_table.close = pipe_close;
+    pipe_op_table.poll = pipe_poll;
     stdout_op_table.write = terminal_write;
+    stdout_op_table.writev = terminal_writev;
     stdin_op_table.read = terminal_read;
+    stdin_op_table.poll = terminal_poll;
+    stdout_op_table.poll = terminal_poll;
     // cannot be used
     stdin_op_table.open = NULL;
     stdin_op_table.write = NULL;
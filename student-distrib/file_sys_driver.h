@@ -11,10 +11,15 @@
 #define DIR_TYPE 1
 #define RTC_TYPE 0
 
-#define PROG_V_ADDR 0x8048000 
-
 #define NAME_LEN 32
 
+// Name index parameters
+#define NAME_HASH_SIZE 128      // power of two, at least twice DENTRY_NUM
+#define NAME_KEY_WORDS (NAME_LEN / 4)
+#define NAME_HASH_SHIFT 16
+#define FNV_OFFSET 0x811C9DC5
+#define FNV_PRIME 0x01000193
+
 // Several globals for the file system structure
 dentry_t* dentry_addr;
 file_boot_block_t* b_block_addr;
@@ -26,8 +31,10 @@ void init_fs(uint32_t fs_addr_start);
 
 // helper functions
 int32_t read_dentry_by_name(const uint8_t* fname, dentry_t* dentry);
+int32_t lookup_dentry_index(const uint8_t* fname);
 int32_t read_dentry_by_index(uint32_t index, dentry_t* dentry);
 int32_t read_data (uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length);
+data_block_t* get_data_block(uint32_t inode, uint32_t offset);
 
 // system calls for files
 int32_t file_close(int32_t fd);
@@ -41,9 +48,4 @@ int32_t dir_open(const uint8_t* dirname);
 int32_t dir_read(int32_t fd, void* buf, int32_t nbytes);
 int32_t dir_write(int32_t fd, const void* buf, int32_t nbytes);
 
-// helper funtion in syscall
-int32_t check_executable(const uint8_t* fname);
-int32_t extract_ip(const uint8_t* fname);
-int32_t load_executable(uint8_t * fname);
-
 void init_fop_table();
@@ -0,0 +1,197 @@
+/* frame_alloc.c - Functions used to hand out physical page frames
+ */
+
+#include "frame_alloc.h"
+#include "lib.h"
+
+#define CHECK_FLAG(flags, bit)   ((flags) & (1 << (bit)))
+#define MBI_MEM     0           // mem_lower/mem_upper valid
+#define MBI_MODS    3           // modules valid
+#define MBI_MMAP    6           // memory map valid
+
+// One bit per frame, set when the frame is in use or not RAM
+static uint32_t frame_map[FRAME_MAP_WORDS];
+static uint32_t free_frames = 0;
+static uint32_t next_word = 0;      // where the next single frame search starts
+static uint8_t frame_ref[FRAME_NUM];    // references to each single frame in use
+
+/* mark_range
+ *
+ * Mark every frame overlapping [start, end) used or free, clamped to the
+ * range the allocator manages
+ * Inputs: start, end -- physical byte range
+ *         used -- 1 to reserve the frames, 0 to release them
+ * Outputs: None
+ * Side Effects: Change frame_map and free_frames
+ */
+static void mark_range(uint32_t start, uint32_t end, int32_t used){
+    uint32_t frame, last;
+    if (start < FRAME_START) start = FRAME_START;
+    if (end > FRAME_LIMIT || end < start) end = FRAME_LIMIT;
+    if (start >= end) return;
+    // free only whole frames, reserve every frame touched
+    if (used) {
+        frame = start >> FRAME_SHIFT;
+        last = (end + FRAME_SIZE - 1) >> FRAME_SHIFT;
+    } else {
+        frame = (start + FRAME_SIZE - 1) >> FRAME_SHIFT;
+        last = end >> FRAME_SHIFT;
+    }
+    for (; frame < last; frame++) {
+        uint32_t bit = 1 << (frame & 31);
+        if (used && !(frame_map[frame >> 5] & bit)) {
+            frame_map[frame >> 5] |= bit;
+            free_frames--;
+        } else if (!used && (frame_map[frame >> 5] & bit)) {
+            frame_map[frame >> 5] &= ~bit;
+            free_frames++;
+        }
+    }
+}
+
+/* frame_init
+ *
+ * Free the frames of every usable RAM region the boot loader reported, then
+ * reserve the modules it loaded. Falls back to mem_upper without a map.
+ * Inputs: mbi -- multiboot information
+ * Outputs: None
+ * Side Effects: Initialize frame_map
+ */
+void frame_init(multiboot_info_t* mbi){
+    memory_map_t* mmap;
+    module_t* mod;
+    uint32_t i, end;
+    memset(frame_map, 0xFF, sizeof(frame_map));
+    free_frames = 0;
+    next_word = 0;
+    if (CHECK_FLAG(mbi->flags, MBI_MMAP)) {
+        for (mmap = (memory_map_t*)mbi->mmap_addr;
+                (uint32_t)mmap < mbi->mmap_addr + mbi->mmap_length;
+                mmap = (memory_map_t*)((uint32_t)mmap + mmap->size + sizeof(mmap->size))) {
+            if (mmap->type != MMAP_AVAILABLE || mmap->base_addr_high) continue;
+            end = mmap->base_addr_low + mmap->length_low;
+            if (mmap->length_high || end < mmap->base_addr_low) end = FRAME_LIMIT;
+            mark_range(mmap->base_addr_low, end, 0);
+        }
+    } else if (CHECK_FLAG(mbi->flags, MBI_MEM)) {
+        mark_range(FRAME_START, MEM_UPPER_BASE + (mbi->mem_upper << KB_SHIFT_BYTES), 0);
+    }
+    // the filesystem image must never be handed out
+    if (CHECK_FLAG(mbi->flags, MBI_MODS)) {
+        mod = (module_t*)mbi->mods_addr;
+        for (i = 0; i < mbi->mods_count; i++, mod++)
+            mark_range(mod->mod_start, mod->mod_end, 1);
+    }
+}
+
+/* frame_alloc
+ *
+ * Take one free frame, searching a word at a time from where the last
+ * search stopped
+ * Inputs: None
+ * Outputs: physical address of the frame, 0 if none is left
+ * Side Effects: Mark the frame used
+ */
+uint32_t frame_alloc(void){
+    uint32_t i, word, bit;
+    if (!free_frames) return 0;
+    for (i = 0; i < FRAME_MAP_WORDS; i++) {
+        word = (next_word + i) % FRAME_MAP_WORDS;
+        if (frame_map[word] == FRAME_WORD_FULL) continue;
+        for (bit = 0; frame_map[word] & (1 << bit); bit++);
+        frame_map[word] |= 1 << bit;
+        frame_ref[(word << 5) + bit] = 1;
+        free_frames--;
+        next_word = word;
+        return ((word << 5) + bit) << FRAME_SHIFT;
+    }
+    return 0;
+}
+
+/* frame_alloc_pages
+ *
+ * Take npages contiguous frames starting on an npages boundary, so that
+ * e.g. a two frame kernel stack is 8KB aligned
+ * Inputs: npages -- power of two, at most FRAME_MAX_RUN
+ * Outputs: physical address of the first frame, 0 if no run is free
+ * Side Effects: Mark the frames used
+ */
+uint32_t frame_alloc_pages(uint32_t npages){
+    uint32_t frame, mask;
+    if (npages == 1) return frame_alloc();
+    if (!npages || npages > FRAME_MAX_RUN || (npages & (npages - 1)) || free_frames < npages) return 0;
+    mask = (npages == FRAME_MAX_RUN) ? FRAME_WORD_FULL : ((1 << npages) - 1);
+    // an aligned run never crosses a word
+    for (frame = 0; frame < FRAME_NUM; frame += npages) {
+        if (frame_map[frame >> 5] & (mask << (frame & 31))) continue;
+        frame_map[frame >> 5] |= mask << (frame & 31);
+        free_frames -= npages;
+        return frame << FRAME_SHIFT;
+    }
+    return 0;
+}
+
+/* frame_free
+ *
+ * Drop one reference to a frame, it is given back with the last one
+ * Inputs: addr -- physical address returned by frame_alloc
+ * Outputs: None
+ * Side Effects: May mark the frame free
+ */
+void frame_free(uint32_t addr){
+    if (addr < FRAME_START || addr >= FRAME_LIMIT) return;
+    if (frame_ref[addr >> FRAME_SHIFT] > 1) {
+        frame_ref[addr >> FRAME_SHIFT]--;
+        return;
+    }
+    frame_ref[addr >> FRAME_SHIFT] = 0;
+    frame_free_pages(addr, 1);
+}
+
+/* frame_get
+ *
+ * Take one more reference to a frame from frame_alloc
+ * Inputs: addr -- physical address of the frame
+ * Outputs: None
+ * Side Effects: Increase the reference count
+ */
+void frame_get(uint32_t addr){
+    if (addr < FRAME_START || addr >= FRAME_LIMIT) return;
+    frame_ref[addr >> FRAME_SHIFT]++;
+}
+
+/* frame_ref_count
+ *
+ * Report how many references a frame from frame_alloc has
+ * Inputs: addr -- physical address of the frame
+ * Outputs: the reference count, 0 for a free frame
+ * Side Effects: None
+ */
+uint32_t frame_ref_count(uint32_t addr){
+    if (addr < FRAME_START || addr >= FRAME_LIMIT) return 0;
+    return frame_ref[addr >> FRAME_SHIFT];
+}
+
+/* frame_free_pages
+ *
+ * Give a run of frames back, addresses outside the managed range are ignored
+ * Inputs: addr -- physical address of the first frame
+ *         npages -- number of frames
+ * Outputs: None
+ * Side Effects: Mark the frames free
+ */
+void frame_free_pages(uint32_t addr, uint32_t npages){
+    if (addr < FRAME_START || addr >= FRAME_LIMIT) return;
+    mark_range(addr, addr + (npages << FRAME_SHIFT), 0);
+}
+
+/* frame_free_count
+ *
+ * Report how many frames are left
+ * Inputs: None
+ * Outputs: number of free frames
+ * Side Effects: None
+ */
+uint32_t frame_free_count(void){
+    return free_frames;
+}
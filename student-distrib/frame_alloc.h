@@ -0,0 +1,46 @@
+/* frame_alloc.h - Defines used to hand out physical page frames
+ */
+
+#ifndef _FRAME_ALLOC_H
+#define _FRAME_ALLOC_H
+
+#include "types.h"
+#include "multiboot.h"
+
+// Frames are 4KB; only RAM between 8MB and 128MB is handed out. The kernel
+// page sits below, the user program page at 128MB virtual above. The whole
+// range is identity mapped for the kernel, so a frame's physical address
+// can be used as a pointer.
+#define FRAME_SIZE          0x1000
+#define FRAME_SHIFT         12
+#define FRAME_START         0x800000
+#define FRAME_LIMIT         0x8000000
+#define FRAME_NUM           (FRAME_LIMIT >> FRAME_SHIFT)
+#define FRAME_MAP_WORDS     (FRAME_NUM / 32)
+#define FRAME_WORD_FULL     0xFFFFFFFF
+#define FRAME_MAX_RUN       32          // largest block frame_alloc_pages hands out
+#define MMAP_AVAILABLE      1           // memory map type of usable RAM
+#define MEM_UPPER_BASE      0x100000    // mem_upper counts KB above 1MB
+#define KB_SHIFT_BYTES      10
+
+// Build the free map from the multiboot memory map
+void frame_init(multiboot_info_t* mbi);
+
+// Take one frame, 0 if memory is exhausted
+uint32_t frame_alloc(void);
+
+// Take npages contiguous frames aligned to their size, npages a power of two
+uint32_t frame_alloc_pages(uint32_t npages);
+
+// Give frames back; frame_free drops one reference
+void frame_free(uint32_t addr);
+void frame_free_pages(uint32_t addr, uint32_t npages);
+
+// Share a frame, e.g. a copy-on-write page mapped by two processes
+void frame_get(uint32_t addr);
+uint32_t frame_ref_count(uint32_t addr);
+
+// Number of frames left
+uint32_t frame_free_count(void);
+
+#endif /* _FRAME_ALLOC_H */
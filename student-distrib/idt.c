@@ -10,6 +10,8 @@
 #include "terminal_driver.h"
 #include "types.h"
 #include "system_call.h"
+#include "loader.h"
+#include "task.h"
 
 #include "signal.h"
 
@@ -36,7 +38,6 @@ EXCEPTION(EX_TS,"Invalid TSS Exception");
 EXCEPTION(EX_NP,"Segment Not Present");
 EXCEPTION(EX_SS,"Stack Fault Exception");
 EXCEPTION(EX_GP,"General Protection Exception");
-EXCEPTION(EX_PF,"Page-Fault Exception");
 /*do not use #15 intel reserved*/
 EXCEPTION(EX_MF,"x87 FPU Floating-Point Error");
 EXCEPTION(EX_AC,"Alignment Check Exception");
@@ -77,7 +78,6 @@ EXCEPTION_SEGFAULT(EX_TS,"Invalid TSS Exception");
 EXCEPTION_SEGFAULT(EX_NP,"Segment Not Present");
 EXCEPTION_SEGFAULT(EX_SS,"Stack Fault Exception");
 EXCEPTION_SEGFAULT(EX_GP,"General Protection Exception");
-EXCEPTION_SEGFAULT(EX_PF,"Page-Fault Exception");
 /*do not use #15 intel reserved*/
 EXCEPTION_SEGFAULT(EX_MF,"x87 FPU Floating-Point Error");
 EXCEPTION_SEGFAULT(EX_AC,"Alignment Check Exception");
@@ -87,6 +87,28 @@ EXCEPTION_SEGFAULT(EX_XF,"SIMD Floating-Point Exception");
 EXCEPTION_SEGFAULT(EX_ND,"Not Defined");   // used for an not defined interrupt
 #endif
 
+/* page_fault_handler
+ *
+ * Page fault handler, called from page_fault_handler_asm
+ * Inputs: addr -- faulting address from CR2
+ *         err -- error code pushed by the processor
+ * Outputs: None
+ * Side Effect: copy a copy-on-write page, fill a demand paged user page,
+ *              or kill the process
+ */
+void page_fault_handler(uint32_t addr, uint32_t err){
+    if (!task_cow_fault(addr, err)) return;
+    if (!exec_page_fault(addr, err)) return;
+    #ifndef TEST_EXTRA
+    printf("%s\n", "Page-Fault Exception");
+    exception_halt();
+    #endif
+
+    #ifdef TEST_EXTRA
+    signal_generate(SEGFAULT);
+    #endif
+}
+
 /* init_idt
  *
  * Fill in every entry on the IDT
@@ -134,7 +156,7 @@ void init_idt(){
     SET_IDT_ENTRY(idt[11], EX_NP);
     SET_IDT_ENTRY(idt[12], EX_SS);
     SET_IDT_ENTRY(idt[13], EX_GP);
-    SET_IDT_ENTRY(idt[14], EX_PF);
+    SET_IDT_ENTRY(idt[14], page_fault_handler_asm);
     // #15 is reserved by Intel
     SET_IDT_ENTRY(idt[16], EX_MF);
     SET_IDT_ENTRY(idt[17], EX_AC);
@@ -15,6 +15,7 @@ extern void rtc_handler_asm();
 extern void rtc_test_handler_asm();
 extern void syscall_handler_asm();
 extern void pit_handler_asm();
+extern void page_fault_handler_asm();
 
 #endif
 
@@ -15,6 +15,10 @@
 #include "file_sys_driver.h"
 #include "system_call.h"
 #include "scheduler.h"
+#include "frame_alloc.h"
+#include "slab.h"
+#include "pcb.h"
+#include "pipe.h"
 
 #include "signal.h"
 
@@ -22,10 +26,22 @@ static uint32_t fs_addr_start;
 
 // #define RUN_TESTS
 
+/* Set by "bench" on the boot command line, see regress.sh */
+static uint32_t bench_boot = 0;
+
 /* Macros. */
 /* Check if the bit BIT in FLAGS is set. */
 #define CHECK_FLAG(flags, bit)   ((flags) & (1 << (bit)))
 
+/* Check if WORD appears in the boot command line CMDLINE. */
+static int32_t cmdline_has(const int8_t* cmdline, const int8_t* word) {
+    uint32_t len = strlen(word);
+    for (; *cmdline != '\0'; cmdline++) {
+        if (strncmp(cmdline, word, len) == 0) return 1;
+    }
+    return 0;
+}
+
 /* Check if MAGIC is valid and print the Multiboot information structure
    pointed by ADDR. */
 void entry(unsigned long magic, unsigned long addr) {
@@ -56,8 +72,13 @@ void entry(unsigned long magic, unsigned long addr) {
         printf("boot_device = 0x%#x\n", (unsigned)mbi->boot_device);
 
     /* Is the command line passed? */
-    if (CHECK_FLAG(mbi->flags, 2))
+    if (CHECK_FLAG(mbi->flags, 2)) {
         printf("cmdline = %s\n", (char *)mbi->cmdline);
+        if (cmdline_has((int8_t *)mbi->cmdline, "bench")) {
+            bench_boot = 1;
+            debugcon_enabled = 1;
+        }
+    }
 
     if (CHECK_FLAG(mbi->flags, 3)) {
         int mod_count = 0;
@@ -155,9 +176,20 @@ void entry(unsigned long magic, unsigned long addr) {
     /* Initialize devices, memory, filesystem, enable device interrupts on the
      * PIC, any other initialization stuff... */
     paging_init();      // Initiate paging
+    frame_init(mbi);    // Initiate physical frame allocator
+    slab_init();        // Initiate kernel object caches
+    pcb_cache_init();   // Initiate pcb and fd table caches
+    pipe_cache_init();  // Initiate pipe cache
+    sysenter_init();    // Initiate SYSENTER system calls
     keyboard_init();    // Initiate Keyboard Interrupt
     init_fs(fs_addr_start); // Initialize file system
     rtc_init();         // Initiate RTC
+    if (bench_boot) {
+        /* Time the kernel paths before the scheduler takes over */
+        sti();
+        regression_bench();
+        cli();
+    }
     pit_init();         // Initiate PIT
     clear_terminal();
 
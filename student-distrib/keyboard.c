@@ -9,6 +9,7 @@
 #include "system_call.h"
 #include "pcb.h"
 #include "paging_init.h"
+#include "scheduler.h"
 
 #include "signal.h"
 
@@ -52,7 +53,7 @@ char key_array[2][58] = {{   // 58 is 0x3A (see right)
 void keyboard_init(){
     int i;
     for (i = 0; i<TER_NUM;i++){
-        buf_status[i] = 0; //disable buffer at first
+        buf_status[i] = BUF_CLOSED; //disable buffer at first
         buffer_pos[i] = 0;
     }
     
@@ -222,7 +223,7 @@ void keyboard_handler(){
             move_cursor(1);
         }
         else if (key == BACKSPACE ){
-            if(!buf_check_empty() && buf_status[cur_ter]){      // do not write && for situation that pressed backspace but empty
+            if(!buf_check_empty() && buf_status[cur_ter] == BUF_OPEN){      // do not write && for situation that pressed backspace but empty
                 delete_bf_cursor();
             }
         }
@@ -239,7 +240,9 @@ void keyboard_handler(){
                    break;
                }
            }
-           buf_status[cur_ter]=0; // set buffer not avaliable to able read to buffer
+           buf_status[cur_ter]=BUF_LINE; // set buffer not avaliable to able read to buffer
+           wake_up_all(&read_wait[cur_ter]);
+           poll_wake();
         }
         // Check the interrupt is a key pressed or released
         else if((key & RELEASE_CHECK) != NULL){
@@ -264,6 +267,8 @@ void keyboard_handler(){
         }
         // Send EOI after interrupt is done
         send_eoi(KEYBOARD_IRQ);
+        // run a woken reader now if it outranks the interrupted process
+        sched_preempt();
     }
     sti();
 
@@ -362,12 +367,12 @@ void add_at_cursor(char content){
     if(process_ter!=cur_ter){
         //switch paging and screen value
         video_mem_page_table[VIDEO_START_OFF].addr = VIDEO_START_OFF;
-        flushTLB();
+        invalidatePage(VIDEO_MEM_ADDR);
         update_screen_buf(process_ter);
         update_x_y(screen_x_buf[cur_ter],screen_y_buf[cur_ter]);
     }
-    if (buf_status[cur_ter]!=1){
-        buf_status[cur_ter]=1;
+    if (buf_status[cur_ter]!=BUF_OPEN){
+        buf_status[cur_ter]=BUF_OPEN;
         key_buf_clear(cur_ter);
     }
     move_screen_to_cursor_position(); //set the next printing char pos to cursor
@@ -395,7 +400,7 @@ void add_at_cursor(char content){
     if(process_ter!=cur_ter){
         //switch paging back
         video_mem_page_table[VIDEO_START_OFF].addr = VIDEO_START_OFF + process_ter + 1;
-        flushTLB();
+        invalidatePage(VIDEO_MEM_ADDR);
         update_x_y(screen_x_buf[process_ter],screen_y_buf[process_ter]);
     }
 }
@@ -414,7 +419,7 @@ void delete_bf_cursor(){
     if(process_ter!=cur_ter){
         //switch paging and screen value
         video_mem_page_table[VIDEO_START_OFF].addr = VIDEO_START_OFF;
-        flushTLB();
+        invalidatePage(VIDEO_MEM_ADDR);
         update_screen_buf(process_ter);
         update_x_y(screen_x_buf[cur_ter],screen_y_buf[cur_ter]);
     }
@@ -437,7 +442,7 @@ void delete_bf_cursor(){
     if(process_ter!=cur_ter){
         //switch paging back
         video_mem_page_table[VIDEO_START_OFF].addr = VIDEO_START_OFF + process_ter + 1;
-        flushTLB();
+        invalidatePage(VIDEO_MEM_ADDR);
         update_x_y(screen_x_buf[process_ter],screen_y_buf[process_ter]);
     }
 }
@@ -479,7 +484,7 @@ void clear_terminal_scheduling(){
     if(process_ter!=cur_ter){
         //switch paging and screen value
         video_mem_page_table[VIDEO_START_OFF].addr = VIDEO_START_OFF;
-        flushTLB();
+        invalidatePage(VIDEO_MEM_ADDR);
         update_screen_buf(process_ter);
         update_x_y(screen_x_buf[cur_ter],screen_y_buf[cur_ter]);
     }
@@ -487,7 +492,7 @@ void clear_terminal_scheduling(){
     if(process_ter!=cur_ter){
         //switch paging back
         video_mem_page_table[VIDEO_START_OFF].addr = VIDEO_START_OFF + process_ter + 1;
-        flushTLB();
+        invalidatePage(VIDEO_MEM_ADDR);
         update_x_y(screen_x_buf[process_ter],screen_y_buf[process_ter]);
     }
 
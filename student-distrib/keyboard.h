@@ -4,6 +4,8 @@
 #ifndef _KEYBOARD_H
 #define _KEYBOARD_H
 
+#include "wait_queue.h"
+
 // Magic numbers defines for keyboard initialization
 #define KEYBOARD_IRQ 1
 #define KEYBOARD_PORT 0x60
@@ -57,10 +59,16 @@
 // multiterminal related
 #define TER_NUM 3   // three terminals
 
+// states of a terminal's line buffer
+#define BUF_CLOSED 0    // nothing typed since the last read
+#define BUF_OPEN 1      // a line is being typed
+#define BUF_LINE 2      // enter was pressed, the line is not read yet
+
 // Define the look-up table according to the scancode and corresponding key
 extern char key_array[2][58]; // 58 is the 0x36 the last key we need
 extern char key_buffer[TER_NUM][KEYBOARD_BUFFER_SIZE];
 volatile int buf_status[TER_NUM];
+wait_queue_t read_wait[TER_NUM];    // terminal readers waiting for enter
 
 // Enable keyboard interrrupt on PIC
 void keyboard_init();
@@ -13,6 +13,9 @@ static int screen_x;
 static int screen_y;
 static char* video_mem = (char *)VIDEO;
 
+// copy console output to the QEMU debug console port
+uint32_t debugcon_enabled = 0;
+
 /* void update_x_y(int s_x, int s_y);
  * Inputs:  int s_x  screen_x value that updates to
  *          int s_y  screen_y value that updates to
@@ -208,6 +211,7 @@ int32_t puts(int8_t* s) {
  * Return Value: void
  *  Function: Output a character to the console */
 void putc(uint8_t c) {
+    if (debugcon_enabled) outb(c, DEBUGCON_PORT);
     if(c == '\n' || c == '\r') {
         screen_y++;
         // screen_y = (++screen_y >= NUM_ROWS) ? 0 : screen_y;
@@ -315,18 +319,19 @@ uint32_t strlen(const int8_t* s) {
  * Return Value: new string
  * Function: set n consecutive bytes of pointer s to value c */
 void* memset(void* s, int32_t c, uint32_t n) {
+    void* dst = s;      // the asm advances edi and ecx
     c &= 0xFF;
     asm volatile ("                 \n\
-            .memset_top:            \n\
+            1:                      \n\
             testl   %%ecx, %%ecx    \n\
-            jz      .memset_done    \n\
+            jz      4f              \n\
             testl   $0x3, %%edi     \n\
-            jz      .memset_aligned \n\
+            jz      2f              \n\
             movb    %%al, (%%edi)   \n\
             addl    $1, %%edi       \n\
             subl    $1, %%ecx       \n\
-            jmp     .memset_top     \n\
-            .memset_aligned:        \n\
+            jmp     1b              \n\
+            2:                      \n\
             movw    %%ds, %%dx      \n\
             movw    %%dx, %%es      \n\
             movl    %%ecx, %%edx    \n\
@@ -334,17 +339,17 @@ void* memset(void* s, int32_t c, uint32_t n) {
             andl    $0x3, %%edx     \n\
             cld                     \n\
             rep     stosl           \n\
-            .memset_bottom:         \n\
+            3:                      \n\
             testl   %%edx, %%edx    \n\
-            jz      .memset_done    \n\
+            jz      4f              \n\
             movb    %%al, (%%edi)   \n\
             addl    $1, %%edi       \n\
             subl    $1, %%edx       \n\
-            jmp     .memset_bottom  \n\
-            .memset_done:           \n\
+            jmp     3b              \n\
+            4:                      \n\
             "
-            :
-            : "a"(c << 24 | c << 16 | c << 8 | c), "D"(s), "c"(n)
+            : "+D"(dst), "+c"(n)
+            : "a"(c << 24 | c << 16 | c << 8 | c)
             : "edx", "memory", "cc"
     );
     return s;
@@ -358,14 +363,15 @@ void* memset(void* s, int32_t c, uint32_t n) {
  * Return Value: new string
  * Function: set lower 16 bits of n consecutive memory locations of pointer s to value c */
 void* memset_word(void* s, int32_t c, uint32_t n) {
+    void* dst = s;
     asm volatile ("                 \n\
             movw    %%ds, %%dx      \n\
             movw    %%dx, %%es      \n\
             cld                     \n\
             rep     stosw           \n\
             "
-            :
-            : "a"(c), "D"(s), "c"(n)
+            : "+D"(dst), "+c"(n)
+            : "a"(c)
             : "edx", "memory", "cc"
     );
     return s;
@@ -378,14 +384,15 @@ void* memset_word(void* s, int32_t c, uint32_t n) {
  * Return Value: new string
  * Function: set n consecutive memory locations of pointer s to value c */
 void* memset_dword(void* s, int32_t c, uint32_t n) {
+    void* dst = s;
     asm volatile ("                 \n\
             movw    %%ds, %%dx      \n\
             movw    %%dx, %%es      \n\
             cld                     \n\
             rep     stosl           \n\
             "
-            :
-            : "a"(c), "D"(s), "c"(n)
+            : "+D"(dst), "+c"(n)
+            : "a"(c)
             : "edx", "memory", "cc"
     );
     return s;
@@ -398,19 +405,20 @@ void* memset_dword(void* s, int32_t c, uint32_t n) {
  * Return Value: pointer to dest
  * Function: copy n bytes of src to dest */
 void* memcpy(void* dest, const void* src, uint32_t n) {
+    void* dst = dest;   // the asm advances esi, edi and ecx
     asm volatile ("                 \n\
-            .memcpy_top:            \n\
+            1:                      \n\
             testl   %%ecx, %%ecx    \n\
-            jz      .memcpy_done    \n\
+            jz      4f              \n\
             testl   $0x3, %%edi     \n\
-            jz      .memcpy_aligned \n\
+            jz      2f              \n\
             movb    (%%esi), %%al   \n\
             movb    %%al, (%%edi)   \n\
             addl    $1, %%edi       \n\
             addl    $1, %%esi       \n\
             subl    $1, %%ecx       \n\
-            jmp     .memcpy_top     \n\
-            .memcpy_aligned:        \n\
+            jmp     1b              \n\
+            2:                      \n\
             movw    %%ds, %%dx      \n\
             movw    %%dx, %%es      \n\
             movl    %%ecx, %%edx    \n\
@@ -418,19 +426,19 @@ void* memcpy(void* dest, const void* src, uint32_t n) {
             andl    $0x3, %%edx     \n\
             cld                     \n\
             rep     movsl           \n\
-            .memcpy_bottom:         \n\
+            3:                      \n\
             testl   %%edx, %%edx    \n\
-            jz      .memcpy_done    \n\
+            jz      4f              \n\
             movb    (%%esi), %%al   \n\
             movb    %%al, (%%edi)   \n\
             addl    $1, %%edi       \n\
             addl    $1, %%esi       \n\
             subl    $1, %%edx       \n\
-            jmp     .memcpy_bottom  \n\
-            .memcpy_done:           \n\
+            jmp     3b              \n\
+            4:                      \n\
             "
+            : "+S"(src), "+D"(dst), "+c"(n)
             :
-            : "S"(src), "D"(dest), "c"(n)
             : "eax", "edx", "memory", "cc"
     );
     return dest;
@@ -444,20 +452,22 @@ void* memcpy(void* dest, const void* src, uint32_t n) {
  * Return Value: pointer to dest
  * Function: move n bytes of src to dest */
 void* memmove(void* dest, const void* src, uint32_t n) {
+    void* dst = dest;   // the asm moves esi, edi and ecx
     asm volatile ("                             \n\
             movw    %%ds, %%dx                  \n\
             movw    %%dx, %%es                  \n\
             cld                                 \n\
             cmp     %%edi, %%esi                \n\
-            jae     .memmove_go                 \n\
+            jae     1f                          \n\
             leal    -1(%%esi, %%ecx), %%esi     \n\
             leal    -1(%%edi, %%ecx), %%edi     \n\
             std                                 \n\
-            .memmove_go:                        \n\
+            1:                                  \n\
             rep     movsb                       \n\
+            cld                                 \n\
             "
+            : "+D"(dst), "+S"(src), "+c"(n)
             :
-            : "D"(dest), "S"(src), "c"(n)
             : "edx", "memory", "cc"
     );
     return dest;
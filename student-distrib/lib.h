@@ -10,6 +10,10 @@
 
 int32_t printf(int8_t *format, ...);
 void putc(uint8_t c);
+
+// QEMU -debugcon receives whatever is written to this port
+#define DEBUGCON_PORT 0xE9
+extern uint32_t debugcon_enabled;
 void move_screen_to_cursor_position();
 int32_t puts(int8_t *s);
 int8_t *itoa(uint32_t value, int8_t* buf, int32_t radix);
@@ -79,6 +83,36 @@ static inline uint32_t inl(port) {
     return val;
 }
 
+/* Reads the low 32 bits of the time-stamp counter. Enough to time
+ * short code paths without needing 64-bit division */
+static inline uint32_t rdtsc_low(void) {
+    uint32_t low;
+    asm volatile ("rdtsc"
+            : "=a"(low)
+            :
+            : "edx"
+    );
+    return low;
+}
+
+/* Returns EDX of a CPUID leaf, where leaf 1 keeps the feature flags */
+static inline uint32_t cpuid_edx(uint32_t leaf) {
+    uint32_t eax = leaf, ebx, ecx = 0, edx;
+    asm volatile ("cpuid"
+            : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx)
+    );
+    return edx;
+}
+
+/* Writes a model specific register */
+static inline void wrmsr(uint32_t msr, uint32_t low, uint32_t high) {
+    asm volatile ("wrmsr"
+            :
+            : "c"(msr), "a"(low), "d"(high)
+            : "memory"
+    );
+}
+
 /* Writes a byte to a port */
 #define outb(data, port)                \
 do {                                    \
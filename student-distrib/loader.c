@@ -0,0 +1,349 @@
+/* loader.c - Functions used to check and load user executables
+ */
+
+#include "loader.h"
+#include "file_sys_driver.h"
+#include "lib.h"
+#include "paging_init.h"
+#include "task.h"
+#include "pcb.h"
+#include "frame_alloc.h"
+
+// Headers that already passed validation, indexed by inode % EXEC_CACHE_SIZE.
+// The filesystem is read only, so an entry never goes stale.
+typedef struct exec_cache_entry {
+    int32_t valid;
+    exec_info_t info;
+} exec_cache_entry_t;
+
+static exec_cache_entry_t exec_cache[EXEC_CACHE_SIZE];
+
+// Shared text of the programs currently running
+static text_share_t text_shares[TEXT_SHARE_NUM];
+
+/* check_elf_header
+ *
+ * Check a header read from the start of a file describes a program we can run
+ * Inputs: hdr -- the header read from the file
+ * Outputs: Return 0 if it is executable
+ *          Return -1 if it is not
+ * Side Effects: None
+ */
+static int32_t check_elf_header(const elf_header_t* hdr){
+    // check magic number
+    if (*(uint32_t*)hdr->e_ident != ELF_MAGIC) return -1;
+    // the entry point must be inside the user program page
+    if (hdr->e_entry < USER_PG_START || hdr->e_entry >= USER_PG_END) return -1;
+    return 0;
+}
+
+/* read_segments
+ *
+ * Read the program header table in one read_data call and keep the PT_LOAD
+ * segments, rejecting any that do not fit the file or the user page
+ * Inputs: hdr -- validated ELF header
+ *         info -- exec_info with inode_idx and file_size set, segments are filled
+ * Outputs: Return 0 for success
+ *          Return -1 for a malformed program header table
+ * Side Effects: None
+ */
+static int32_t read_segments(const elf_header_t* hdr, exec_info_t* info){
+    elf_phdr_t phdrs[EXEC_MAX_PHDRS];
+    uint32_t i, table_size;
+    exec_seg_t* seg;
+    if (hdr->e_phentsize != sizeof(elf_phdr_t) || hdr->e_phnum == 0 || hdr->e_phnum > EXEC_MAX_PHDRS) return -1;
+    table_size = hdr->e_phnum * sizeof(elf_phdr_t);
+    if (read_data(info->inode_idx, hdr->e_phoff, (uint8_t*)phdrs, table_size) != table_size) return -1;
+    info->seg_cnt = 0;
+    for (i = 0; i < hdr->e_phnum; i++) {
+        if (phdrs[i].p_type != PT_LOAD) continue;
+        if (info->seg_cnt == EXEC_MAX_SEGS) return -1;
+        if (phdrs[i].p_filesz > phdrs[i].p_memsz) return -1;
+        if (phdrs[i].p_offset > info->file_size || phdrs[i].p_filesz > info->file_size - phdrs[i].p_offset) return -1;
+        if (phdrs[i].p_vaddr < USER_PG_START || phdrs[i].p_memsz > USER_PG_END - phdrs[i].p_vaddr) return -1;
+        seg = &info->segs[info->seg_cnt++];
+        seg->vaddr = phdrs[i].p_vaddr;
+        seg->offset = phdrs[i].p_offset;
+        seg->filesz = phdrs[i].p_filesz;
+        seg->memsz = phdrs[i].p_memsz;
+        seg->flags = phdrs[i].p_flags;
+    }
+    return info->seg_cnt ? 0 : -1;
+}
+
+/* exec_prepare
+ *
+ * Resolve the dentry of an executable once, read its ELF header in a single
+ * read_data call, validate it and pull out the entry point and the PT_LOAD
+ * segments. Headers that were validated before are served from exec_cache
+ * without touching the file.
+ * Input: fname -- File name
+ *        info -- filled with the inode, size and entry point of the program
+ * Output: Return 0 if the file is executable
+ *         Return -1 if not
+ * Side Effect: May add the header to exec_cache
+ */
+int32_t exec_prepare(const uint8_t* fname, exec_info_t* info){
+    dentry_t dentry;
+    elf_header_t hdr;
+    exec_cache_entry_t* cached;
+    if (!fname || !info) return -1;
+    if (read_dentry_by_name(fname, &dentry) == -1) return -1;
+    if (dentry.filetype != FILE_TYPE) return -1;
+    cached = &exec_cache[dentry.inode_num % EXEC_CACHE_SIZE];
+    if (cached->valid && cached->info.inode_idx == dentry.inode_num) {
+        *info = cached->info;
+        return 0;
+    }
+    if (read_data(dentry.inode_num, 0, (uint8_t*)&hdr, sizeof(hdr)) != sizeof(hdr)) return -1;
+    if (check_elf_header(&hdr)) return -1;
+    info->inode_idx = dentry.inode_num;
+    info->file_size = inode_start_addr[dentry.inode_num].length;
+    info->entry = hdr.e_entry;
+    if (read_segments(&hdr, info)) return -1;
+    cached->info = *info;
+    cached->valid = 1;
+    return 0;
+}
+
+/* exec_fill_page
+ *
+ * Fill one 4KB page of the user program page from a program image: zero it,
+ * then copy the file bytes of every segment that fall inside the page.
+ * Input: info -- the program image
+ *        page -- page aligned user virtual address the contents belong at
+ *        dest -- where to write them, the page itself once mapped or a frame
+ * Output: None
+ * Side Effect: Overwrite dest
+ */
+void exec_fill_page(const exec_info_t* info, uint32_t page, uint8_t* dest){
+    uint32_t i, start, end;
+    const exec_seg_t* seg;
+    memset(dest, 0, USER_PG_SIZE);
+    for (i = 0; i < info->seg_cnt; i++) {
+        seg = &info->segs[i];
+        start = (seg->vaddr > page) ? seg->vaddr : page;
+        end = seg->vaddr + seg->filesz;
+        if (end > page + USER_PG_SIZE) end = page + USER_PG_SIZE;
+        if (start >= end) continue;
+        read_data(info->inode_idx, seg->offset + (start - seg->vaddr), dest + (start - page), end - start);
+    }
+}
+
+/* text_block_addr
+ *
+ * Decide whether a user page can be mapped straight onto a filesystem data
+ * block. That is the case when the page lies in a single read-only segment,
+ * holds no .bss, and the segment's file offset and virtual address agree
+ * modulo the page size so the page lines up with one whole data block.
+ * Input: info -- the program image
+ *        page -- page aligned user virtual address
+ * Output: Return the address of the data block to map
+ *         Return 0 if the page needs a private copy
+ * Side Effect: None
+ */
+static uint32_t text_block_addr(const exec_info_t* info, uint32_t page){
+    uint32_t i;
+    const exec_seg_t* seg;
+    const exec_seg_t* text = NULL;
+    data_block_t* block;
+    for (i = 0; i < info->seg_cnt; i++) {
+        seg = &info->segs[i];
+        if (seg->vaddr >= page + USER_PG_SIZE || seg->vaddr + seg->memsz <= page) continue;
+        if ((seg->flags & PF_W) || text) return 0;  // writable data or a second segment shares the page
+        text = seg;
+    }
+    if (!text) return 0;
+    if (text->memsz > text->filesz && text->vaddr + text->filesz < page + USER_PG_SIZE) return 0;
+    if ((text->vaddr - text->offset) & (USER_PG_SIZE - 1)) return 0;
+    block = get_data_block(info->inode_idx, text->offset + (page - text->vaddr));
+    if (!block || ((uint32_t)block & (USER_PG_SIZE - 1))) return 0;
+    return (uint32_t)block;
+}
+
+/* page_is_readonly
+ *
+ * Check whether a user page only holds read-only segments
+ * Input: info -- the program image
+ *        page -- page aligned user virtual address
+ * Output: Return 1 if at least one segment and no writable segment overlaps it
+ *         Return 0 otherwise
+ * Side Effect: None
+ */
+static int32_t page_is_readonly(const exec_info_t* info, uint32_t page){
+    uint32_t i;
+    int32_t found = 0;
+    const exec_seg_t* seg;
+    for (i = 0; i < info->seg_cnt; i++) {
+        seg = &info->segs[i];
+        if (seg->vaddr >= page + USER_PG_SIZE || seg->vaddr + seg->memsz <= page) continue;
+        if (seg->flags & PF_W) return 0;
+        found = 1;
+    }
+    return found;
+}
+
+/* shared_text_frame
+ *
+ * Find the shared frame of a read-only page, populating it on the first
+ * touch by any process running the program: aligned text maps the
+ * filesystem block, other read-only pages get a frame from frame_alloc
+ * filled once
+ * Input: info -- the program image
+ *        text -- the program's shared text
+ *        page -- page aligned user virtual address
+ * Output: Return the physical frame
+ *         Return 0 if the page cannot be shared
+ * Side Effect: May populate the shared frame
+ */
+static uint32_t shared_text_frame(const exec_info_t* info, text_share_t* text, uint32_t page){
+    uint32_t idx, frame;
+    if (!text || page < text->base || !page_is_readonly(info, page)) return 0;
+    idx = (page - text->base) / USER_PG_SIZE;
+    if (idx >= TEXT_SHARE_PAGES) return 0;
+    if (text->frames[idx]) return text->frames[idx];
+    frame = text_block_addr(info, page);
+    if (!frame) {
+        frame = frame_alloc();
+        if (!frame) return 0;
+        exec_fill_page(info, page, (uint8_t*)frame);
+        text->owned |= 1 << idx;
+    }
+    text->frames[idx] = frame;
+    return frame;
+}
+
+/* exec_share_get
+ *
+ * Take a reference on the shared text of a program, setting up an empty
+ * set of frames on its first exec
+ * Input: info -- the program image
+ * Output: Return the shared text
+ *         Return NULL if no slot is free, the program then runs unshared
+ * Side Effect: Increase the reference count
+ */
+text_share_t* exec_share_get(const exec_info_t* info){
+    uint32_t i;
+    text_share_t* free_slot = NULL;
+    for (i = 0; i < TEXT_SHARE_NUM; i++) {
+        if (text_shares[i].refcnt && text_shares[i].inode_idx == info->inode_idx) {
+            text_shares[i].refcnt++;
+            return &text_shares[i];
+        }
+        if (!text_shares[i].refcnt && !free_slot) free_slot = &text_shares[i];
+    }
+    if (!free_slot) return NULL;
+    memset(free_slot, 0, sizeof(text_share_t));
+    free_slot->inode_idx = info->inode_idx;
+    free_slot->refcnt = 1;
+    free_slot->base = USER_PG_END;
+    for (i = 0; i < info->seg_cnt; i++) {
+        if (!(info->segs[i].flags & PF_W) && info->segs[i].vaddr < free_slot->base)
+            free_slot->base = info->segs[i].vaddr & ~(USER_PG_SIZE - 1);
+    }
+    return free_slot;
+}
+
+/* exec_share_put
+ *
+ * Drop a reference on a program's shared text, releasing its frames when
+ * the last process running it halts
+ * Input: text -- the shared text, may be NULL
+ * Output: None
+ * Side Effect: Decrease the reference count, may free frames
+ */
+void exec_share_put(text_share_t* text){
+    uint32_t i;
+    if (!text || !text->refcnt) return;
+    if (--text->refcnt) return;
+    for (i = 0; i < TEXT_SHARE_PAGES; i++) {
+        if (text->owned & (1 << i)) frame_free(text->frames[i]);
+        text->frames[i] = 0;
+    }
+    text->owned = 0;
+}
+
+/* exec_share_dup
+ *
+ * Take another reference on shared text a process already holds, for fork
+ * Input: text -- the shared text, may be NULL
+ * Output: Return text
+ * Side Effect: Increase the reference count
+ */
+text_share_t* exec_share_dup(text_share_t* text){
+    if (text) text->refcnt++;
+    return text;
+}
+
+/* exec_map_page
+ *
+ * Make one page of a process's user program page present. Read-only pages
+ * map the frames shared by every run of the program, everything else gets
+ * a private page filled from the image.
+ * Input: info -- the program image
+ *        text -- the program's shared text, may be NULL
+ *        process_id -- owner of the user page, its page table must be active
+ *        page -- page aligned user virtual address
+ * Output: Return 0 if success
+ *         Return -1 if no frame is left
+ * Side Effect: Map the page, may fill it
+ */
+static int32_t exec_map_page(const exec_info_t* info, text_share_t* text, uint8_t process_id, uint32_t page){
+    uint32_t frame = shared_text_frame(info, text, page);
+    if (frame) {
+        task_map_readonly(process_id, page, frame);
+        return 0;
+    }
+    if (task_map_page(process_id, page)) return -1;
+    exec_fill_page(info, page, (uint8_t*)page);
+    return 0;
+}
+
+/* exec_load
+ *
+ * Load a prepared executable into a process's user page. Only the PT_LOAD
+ * segments are used, so symbol tables and debug sections left in the file
+ * are never touched; the .bss part of each segment is zero filled and
+ * read-only pages are shared with other runs of the program. With
+ * DEMAND_PAGING nothing is mapped here and exec_page_fault maps each page on
+ * first touch.
+ * Input: info -- filled by exec_prepare
+ *        text -- the program's shared text from exec_share_get
+ *        process_id -- owner of the user page, its page table must be active
+ * Output: Return 0 if success
+ *         Return -1 if fail
+ * Side Effect: Map and fill the pages holding the program segments
+ */
+int32_t exec_load(const exec_info_t* info, text_share_t* text, uint8_t process_id){
+#ifndef DEMAND_PAGING
+    uint32_t i, page;
+    const exec_seg_t* seg;
+    for (i = 0; i < info->seg_cnt; i++) {
+        seg = &info->segs[i];
+        for (page = seg->vaddr & ~(USER_PG_SIZE - 1); page < seg->vaddr + seg->memsz; page += USER_PG_SIZE)
+            if (exec_map_page(info, text, process_id, page)) return -1;
+    }
+#endif
+    return 0;
+}
+
+/* exec_page_fault
+ *
+ * Handle a fault on a not-present page of the user program page by mapping
+ * the page from the current process's image. Pages outside the image (stack,
+ * .bss tail) come up zeroed.
+ * Input: addr -- faulting address from CR2
+ *        err -- page fault error code
+ * Output: Return 0 if the fault was handled
+ *         Return -1 if it is a real fault or memory is exhausted
+ * Side Effect: Map and fill one user page
+ */
+int32_t exec_page_fault(uint32_t addr, uint32_t err){
+    pcb_t* cur_pcb;
+    uint32_t page;
+    if (addr < USER_PG_START || addr >= USER_PG_END || (err & PF_PRESENT)) return -1;
+    if (get_process_cnt() == 0) return -1;
+    cur_pcb = get_pcb();
+    page = addr & ~(USER_PG_SIZE - 1);
+    return exec_map_page(&cur_pcb->exec, cur_pcb->text, cur_pcb->current_id, page);
+}
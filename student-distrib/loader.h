@@ -0,0 +1,106 @@
+/* loader.h - Defines used to check and load user executables
+ */
+
+#ifndef _LOADER_H
+#define _LOADER_H
+
+#include "types.h"
+
+#define PROG_V_ADDR     0x8048000   // where user programs are linked to run
+#define USER_PG_START   0x8000000   // 128 MB, the user program page
+#define USER_PG_END     0x8400000   // 132 MB
+
+// ELF header constants
+#define ELF_MAGIC       0x464C457F  // "\177ELF" read as a little endian word
+#define ELF_IDENT_LEN   16
+#define PT_LOAD         1           // program header type of a loadable segment
+#define PF_W            0x2         // segment flag: writable
+#define EXEC_MAX_PHDRS  8           // program headers read per executable
+#define EXEC_MAX_SEGS   4           // PT_LOAD segments kept per executable
+
+// Number of validated headers kept, indexed by inode
+#define EXEC_CACHE_SIZE 64
+
+// Shared read-only text
+#define TEXT_SHARE_NUM  16          // programs sharing text at once, others run unshared
+#define TEXT_SHARE_PAGES 16         // read-only pages shared per program
+
+// Fill user pages from the image on first touch instead of copying the
+// whole image at exec. Comment out to load eagerly.
+#define DEMAND_PAGING
+
+// ELF file header, 52 bytes at the start of every executable
+typedef struct elf_header {
+    uint8_t  e_ident[ELF_IDENT_LEN];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint32_t e_entry;       // virtual address of the first instruction
+    uint32_t e_phoff;
+    uint32_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+} elf_header_t;
+
+// ELF program header, describes one segment of the file
+typedef struct elf_phdr {
+    uint32_t p_type;
+    uint32_t p_offset;      // offset of the segment in the file
+    uint32_t p_vaddr;       // virtual address to load it to
+    uint32_t p_paddr;
+    uint32_t p_filesz;      // bytes present in the file
+    uint32_t p_memsz;       // bytes in memory, the rest after p_filesz is .bss
+    uint32_t p_flags;
+    uint32_t p_align;
+} elf_phdr_t;
+
+// A PT_LOAD segment, already checked to fit in the user page
+typedef struct exec_seg {
+    uint32_t vaddr;
+    uint32_t offset;
+    uint32_t filesz;
+    uint32_t memsz;
+    uint32_t flags;
+} exec_seg_t;
+
+// Everything the loader needs to start a program, filled once per exec
+typedef struct exec_info {
+    int32_t inode_idx;      // inode of the executable
+    uint32_t file_size;     // length of the file in bytes
+    uint32_t entry;         // entry point taken from the ELF header
+    uint32_t seg_cnt;       // number of PT_LOAD segments
+    exec_seg_t segs[EXEC_MAX_SEGS];
+} exec_info_t;
+
+// Read-only pages of one program, shared by every process running it
+typedef struct text_share {
+    int32_t inode_idx;      // program the pages belong to
+    uint32_t refcnt;        // processes mapping them, 0 marks a free slot
+    uint32_t base;          // user address of the first read-only page
+    uint32_t frames[TEXT_SHARE_PAGES];  // physical frame of each page, 0 until first touch
+    uint32_t owned;         // bit mask of frames taken from frame_alloc
+} text_share_t;
+
+// Resolve and validate an executable, fill its exec_info
+int32_t exec_prepare(const uint8_t* fname, exec_info_t* info);
+
+// Take and release a reference on a program's shared text
+text_share_t* exec_share_get(const exec_info_t* info);
+void exec_share_put(text_share_t* text);
+text_share_t* exec_share_dup(text_share_t* text);
+
+// Map a prepared executable into a process's user page
+int32_t exec_load(const exec_info_t* info, text_share_t* text, uint8_t process_id);
+
+// Fill one user page from a program image
+void exec_fill_page(const exec_info_t* info, uint32_t page, uint8_t* dest);
+
+// Page fault hook, fills a not-present user page of the current process
+int32_t exec_page_fault(uint32_t addr, uint32_t err);
+
+#endif /* _LOADER_H */
@@ -4,6 +4,10 @@
 #include "types.h"
 #include "paging_init.h"
 #include "x86_desc.h"
+#include "frame_alloc.h"
+
+pte_t* user_page_table[MAX_PROCESS];
+pde_t* process_page_directory[MAX_PROCESS];
 
 /* paging_init
  *
@@ -67,7 +71,7 @@ void paging_init(void) {
     video_mem_page_table[VIDEO_START_OFF].access = 0;
     video_mem_page_table[VIDEO_START_OFF].dirty = 0;
     video_mem_page_table[VIDEO_START_OFF].pat = 0;
-    video_mem_page_table[VIDEO_START_OFF].global = 0;
+    video_mem_page_table[VIDEO_START_OFF].global = 1;     // kept across CR3 loads
     video_mem_page_table[VIDEO_START_OFF].available = 0;
     video_mem_page_table[VIDEO_START_OFF].addr = VIDEO_START_OFF;
 
@@ -81,7 +85,7 @@ void paging_init(void) {
         video_mem_page_table[VIDEO_START_OFF+i].access = 0;
         video_mem_page_table[VIDEO_START_OFF+i].dirty = 0;
         video_mem_page_table[VIDEO_START_OFF+i].pat = 0;
-        video_mem_page_table[VIDEO_START_OFF+i].global = 0;
+        video_mem_page_table[VIDEO_START_OFF+i].global = 1;
         video_mem_page_table[VIDEO_START_OFF+i].available = 0;
         video_mem_page_table[VIDEO_START_OFF+i].addr = VIDEO_START_OFF+i;
     }
@@ -103,6 +107,7 @@ void paging_init(void) {
     // init user program paging
     init_user_program_pg();
     init_user_video_pg();
+    init_frame_pg();
 
     // Set CR0, CR3 and CR4 in correct order
     enablePSE();                                // Enable page size extent
@@ -113,21 +118,24 @@ void paging_init(void) {
 
 /* init_user_program_pg
  *
- * Set entries for user program directory; initialize the 4MB page
+ * Set entries for user program directory; the 4MB user program page is
+ * mapped through a 4KB page table per process. The entry here is the
+ * template copied into every process directory, task_init points it at
+ * the process's own table.
  * Inputs: None
  * Outputs: None
  * Side Effects: initialize page directory
  */
 void init_user_program_pg(void){
-    page_directory[MB_128_V_OFF].present = 1;
+    page_directory[MB_128_V_OFF].present = 0;
     page_directory[MB_128_V_OFF].r_w = 1;
     page_directory[MB_128_V_OFF].u_s = 1;         // Set to user level
     page_directory[MB_128_V_OFF].pwt = 0;
     page_directory[MB_128_V_OFF].pcd = 0;
     page_directory[MB_128_V_OFF].access = 0;
     page_directory[MB_128_V_OFF].dirty = 0;
-    page_directory[MB_128_V_OFF].page_size = 1;
-    page_directory[MB_128_V_OFF].global = 1;
+    page_directory[MB_128_V_OFF].page_size = 0;
+    page_directory[MB_128_V_OFF].global = 0;
     page_directory[MB_128_V_OFF].available = 0;
     page_directory[MB_128_V_OFF].addr = 0;
     return;
@@ -185,3 +193,30 @@ void init_user_video_pg(void){
     page_directory[USER_VIDEO_V_OFF].addr = (unsigned int)user_video_page_table >> SHIFT_OFF;
     return;    
 }
+
+/* init_frame_pg
+ *
+ * Identity map physical memory from 8MB up to the user program page with
+ * supervisor 4MB pages, so the kernel can use any frame from frame_alloc
+ * (page tables, kernel stacks, user pages) through its physical address
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: initialize page directory
+ */
+void init_frame_pg(void){
+    int i;
+    for (i = FRAME_START >> MB_4_PG_OFF; i < FRAME_LIMIT >> MB_4_PG_OFF; i++) {
+        page_directory[i].present = 1;
+        page_directory[i].r_w = 1;
+        page_directory[i].u_s = 0;
+        page_directory[i].pwt = 0;
+        page_directory[i].pcd = 0;
+        page_directory[i].access = 0;
+        page_directory[i].dirty = 0;
+        page_directory[i].page_size = 1;
+        page_directory[i].global = 1;
+        page_directory[i].available = 0;
+        page_directory[i].addr = (i << MB_4_PG_OFF) >> SHIFT_OFF;
+    }
+    return;
+}
@@ -2,6 +2,8 @@
  */
 
 #include "types.h"
+#include "x86_desc.h"
+#include "task.h"
 
 #ifndef _PAGING_INIT_H
 #define _PAGING_INIT_H
@@ -16,11 +18,23 @@
 #define MB_128_V_OFF        (MB_128_V_ADDR >> MB_4_PG_OFF)        
 #define VIDEO_V_OFF         0
 #define KERNEL_V_OFF        1   
-#define USER_VIDEO_V_OFF    2   
-#define USER_VIDEO_V_ADDR   0x8B8000    // Arbitrary picked location for video memory
+#define USER_VIDEO_V_ADDR   0x84B8000   // Arbitrary picked location above the user program page
+#define USER_VIDEO_V_OFF    (USER_VIDEO_V_ADDR >> MB_4_PG_OFF)
+#define VIDEO_MEM_ADDR      (VIDEO_START_OFF << SHIFT_OFF)  // kernel view of the video page
 #define TER_NUMBER          3
+#define USER_PG_SIZE        0x1000      // the user program page is mapped in 4KB pages
+#define PF_PRESENT          0x1         // page fault error code: page was present
+
+// 4KB page table for the user program page at 128MB of each process,
+// allocated from frame_alloc when the pid is first used
+extern pte_t* user_page_table[MAX_PROCESS];
+
+// Page directory of each process, the kernel entries are shared by all of them
+extern pde_t* process_page_directory[MAX_PROCESS];
+
 // ASM code that set page directory base pointer to PDBR(CR3) 
 extern void loadPageDirectory(uint32_t*);
+extern uint32_t* getPageDirectory();
 
 // ASM code that set Bit4 of CR4 to enable PSE
 extern void enablePSE();
@@ -31,6 +45,9 @@ extern void enablePGE();
 // ASM code that set Bit31 of CR0 to enbale PG
 extern void enablePaging();
 
+// ASM code that drops the TLB entry of one page
+extern void invalidatePage(uint32_t vaddr);
+
 // Initialize the paging
 void paging_init(void);
 
@@ -40,4 +57,7 @@ void init_user_program_pg(void);
 // Pre alloc the virtual memory address for user video memory
 void init_user_video_pg(void);
 
+// Identity map the RAM frame_alloc hands out
+void init_frame_pg(void);
+
 #endif
@@ -3,6 +3,49 @@
 #include "lib.h"
 
 #include "signal.h"
+#include "slab.h"
+#include "scheduler.h"
+#include "pipe.h"
+
+pcb_t* pcb_table[MAX_PROCESS];
+
+static kmem_cache_t* pcb_cache;     // pcb_t objects
+static kmem_cache_t* fd_cache;      // fd tables of MAX_FILE entries
+
+/* pcb_cache_init
+ *
+ * Create the slab caches pcbs and fd tables come from
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: Create two caches
+ */
+void pcb_cache_init(void){
+    pcb_cache = kmem_cache_create("pcb", sizeof(pcb_t));
+    fd_cache = kmem_cache_create("fd_table", sizeof(fd_t) * MAX_FILE);
+}
+
+/* alloc_pcb
+ *
+ * Allocate a pcb and its fd table and tie the pcb to a kernel stack: the
+ * lowest word of the stack points at the pcb so get_pcb can find it
+ * Inputs: kernel_stack -- base of an 8KB aligned kernel stack
+ * Outputs: the pcb, NULL if memory is exhausted
+ * Side Effects: Write the pcb pointer at the stack base
+ */
+pcb_t* alloc_pcb(uint32_t kernel_stack){
+    pcb_t* newpcb = kmem_cache_alloc(pcb_cache);
+    fd_t* fd_array = kmem_cache_alloc(fd_cache);
+    if (!newpcb || !fd_array) {
+        kmem_cache_free(pcb_cache, newpcb);
+        kmem_cache_free(fd_cache, fd_array);
+        return NULL;
+    }
+    memset(newpcb, 0, sizeof(pcb_t));
+    newpcb -> fd_array = fd_array;
+    newpcb -> kernel_stack = kernel_stack;
+    *(pcb_t**)kernel_stack = newpcb;
+    return newpcb;
+}
 
 /* init_pcb
  *
@@ -17,11 +60,31 @@ pcb_t* init_pcb(uint8_t process_id, pcb_t* parent_pcb){
 
     pcb_t* newpcb = get_pcb_by_id(process_id);
     newpcb -> current_id = process_id;
+    // not runnable until the caller wakes it
+    newpcb -> state = TASK_BLOCKED;
+    newpcb -> wait_pid = -1;
+    newpcb -> wait_q = NULL;
+    newpcb -> wait_next = NULL;
+    newpcb -> ring = NULL;
+    newpcb -> run_next = NULL;
+    newpcb -> run_prev = NULL;
+    newpcb -> run_level = SCHED_PRIO_NUM;
+    newpcb -> start_tick = pit_cnt;
+    newpcb -> run_ticks = 0;
+    newpcb -> run_cnt = 0;
+    newpcb -> nvcsw = 0;
+    newpcb -> nivcsw = 0;
+    newpcb -> last_tick = pit_cnt;
+    newpcb -> wait_cycles = 0;
+    // children run at their parent's priority
+    newpcb -> priority = parent_pcb ? parent_pcb -> priority : SCHED_PRIO_DEFAULT;
+    newpcb -> boost = 0;
     // set entries for fda
     for (i=0;i<MAX_FILE;i++){
         newpcb -> fd_array[i].inode_idx = 0;
         newpcb -> fd_array[i].file_pos =0;
         newpcb -> fd_array[i].flag=0;
+        newpcb -> fd_array[i].pipe = NULL;
     }
     newpcb -> fd_array[0].file_op_table_ptr = &stdin_op_table;
     newpcb -> fd_array[1].file_op_table_ptr = &stdout_op_table;
@@ -37,16 +100,10 @@ pcb_t* init_pcb(uint8_t process_id, pcb_t* parent_pcb){
     if(parent_pcb == 0){
         newpcb->parent_id =0;
         newpcb->parent_pointer =0;
-        newpcb->stack_bp =0;
-        newpcb->stack_p =0;
-        newpcb->stack_switch_bp =0;
         newpcb->stack_switch_p =0;
     }else{
         newpcb->parent_id = parent_pcb->current_id;
         newpcb->parent_pointer = (int32_t)parent_pcb;
-        newpcb->stack_bp =0;
-        newpcb->stack_p =0;
-        newpcb->stack_switch_bp =0;
         newpcb->stack_switch_p =0;
         // store_current(newpcb);
     }
@@ -71,9 +128,21 @@ pcb_t* init_pcb(uint8_t process_id, pcb_t* parent_pcb){
     return newpcb;
 }
 
+/* free_pcb
+ *
+ * Give a pcb and its fd table back to their caches
+ * Inputs: pcb -- from alloc_pcb
+ * Outputs: None
+ * Side Effects: None
+ */
+void free_pcb(pcb_t* pcb){
+    kmem_cache_free(fd_cache, pcb -> fd_array);
+    kmem_cache_free(pcb_cache, pcb);
+}
+
 /* get_pcb
  *
- * get pcb from current esp
+ * get pcb from the pointer at the base of the current kernel stack
  * Inputs: None
  * Outputs: cur_pcb -- the pointer to current pcb
  * Side Effects: None
@@ -85,7 +154,7 @@ pcb_t* get_pcb(){
         :
         : "memory"
     );
-    return (pcb_t*)(esp & PCB_MASK);
+    return *(pcb_t**)(esp & PCB_MASK);
 }
 
 /* get_pcb_by_id
@@ -96,7 +165,18 @@ pcb_t* get_pcb(){
  * Side Effects: None
  */
 pcb_t* get_pcb_by_id(uint8_t process_id){
-    return (pcb_t*)(MB_8-(KB_8*(process_id+1))); // pcb is stored as stack top
+    return pcb_table[process_id];
+}
+
+/* get_kernel_stack
+ *
+ * get the initial kernel stack pointer of a pid, for tss.esp0
+ * Inputs: process_id -- the pid
+ * Outputs: the top of the pid's kernel stack
+ * Side Effects: None
+ */
+uint32_t get_kernel_stack(uint8_t process_id){
+    return pcb_table[process_id] -> kernel_stack + KB_8 - 4;  // 4 for a line of 32bits
 }
 
 /* get_fa
@@ -112,15 +192,17 @@ fd_t* get_fa(){
 
 /* close_fds
  *
- * Close all the existing fds in fa
- * Inputs: None
+ * Close all the existing fds of a process
+ * Inputs: pcb -- the process, not necessarily the current one
  * Outputs: None
  * Side Effects: Set all fd to not in use
  */
-void close_fds(){
-    fd_t* fda = get_fa();
+void close_fds(pcb_t* pcb){
+    fd_t* fda = pcb -> fd_array;
     int i;
     for(i = 0; i < MAX_FILE; i++) {
+        // pipe ends are the only files that hold anything
+        if (fda[i].flag) pipe_put(&fda[i]);
         fda[i].flag = FILE_NOT_IN_USE;
     }
     return;
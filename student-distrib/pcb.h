@@ -1,5 +1,6 @@
 #include "types.h"
 #include "x86_desc.h"
+#include "task.h"
 
 #define PCB_MASK 0xFFFFE000 // bit mask for top 8kb 
 #define MB_8 0x0800000  // 8 MB
@@ -14,7 +15,14 @@
 pcb_t* init_pcb(uint8_t process_id, pcb_t* parent_pcb);
 pcb_t* get_pcb();
 pcb_t* get_pcb_by_id(uint8_t process_id);
+uint32_t get_kernel_stack(uint8_t process_id);
+void pcb_cache_init(void);
+pcb_t* alloc_pcb(uint32_t kernel_stack);
+void free_pcb(pcb_t* pcb);
+
+// pcb of each pid, set by task_init
+extern pcb_t* pcb_table[MAX_PROCESS];
 void store_current(pcb_t* pcb);
 void restore_parent(uint8_t process_id);
 fd_t* get_fa();
-void close_fds();
+void close_fds(pcb_t* pcb);
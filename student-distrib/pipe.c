@@ -0,0 +1,232 @@
+/* pipe.c - Functions for anonymous pipes between processes
+ */
+
+#include "pipe.h"
+#include "pcb.h"
+#include "slab.h"
+#include "frame_alloc.h"
+#include "lib.h"
+
+static kmem_cache_t* pipe_cache;
+
+/* pipe_cache_init
+ *
+ * Create the slab cache pipes come from
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: Create a cache
+ */
+void pipe_cache_init(void){
+    pipe_cache = kmem_cache_create("pipe", sizeof(pipe_t));
+}
+
+/* pipe_create
+ *
+ * Make an empty pipe with one fd on each end
+ * Inputs: read_fd -- filled with the read end
+ *         write_fd -- filled with the write end
+ * Outputs: Return 0 for success
+ *          Return -1 if memory is exhausted
+ * Side Effects: Allocate the pipe and its buffer frame
+ */
+int32_t pipe_create(fd_t* read_fd, fd_t* write_fd){
+    pipe_t* pipe = kmem_cache_alloc(pipe_cache);
+    uint32_t buf = frame_alloc();
+    if (!pipe || !buf) {
+        kmem_cache_free(pipe_cache, pipe);
+        if (buf) frame_free(buf);
+        return -1;
+    }
+    memset(pipe, 0, sizeof(pipe_t));
+    pipe -> buf = (uint8_t*)buf;
+    pipe -> readers = 1;
+    pipe -> writers = 1;
+    read_fd -> file_op_table_ptr = &pipe_op_table;
+    read_fd -> inode_idx = 0;
+    read_fd -> file_pos = PIPE_READ_END;
+    read_fd -> flag = FILE_IN_USE;
+    read_fd -> pipe = pipe;
+    *write_fd = *read_fd;
+    write_fd -> file_pos = PIPE_WRITE_END;
+    return 0;
+}
+
+/* pipe_get
+ *
+ * Count another fd on the end an fd refers to, after fork or dup2
+ * Inputs: fd -- the copied fd, may be any kind of file
+ * Outputs: None
+ * Side Effects: None
+ */
+void pipe_get(fd_t* fd){
+    uint32_t flags;
+    if (!fd -> flag || !fd -> pipe) return;
+    cli_and_save(flags);
+    if (fd -> file_pos == PIPE_READ_END) fd -> pipe -> readers++;
+    else fd -> pipe -> writers++;
+    restore_flags(flags);
+}
+
+/* pipe_put
+ *
+ * Drop the reference an fd holds on its end. When the last writer goes
+ * readers see the end of the data, when the last reader goes writes fail.
+ * The pipe is freed with its last fd.
+ * Inputs: fd -- the fd being closed, not necessarily of the current process
+ * Outputs: None
+ * Side Effects: wake the sleepers on the other end, clear fd->pipe
+ */
+void pipe_put(fd_t* fd){
+    uint32_t flags;
+    pipe_t* pipe = fd -> pipe;
+    if (!pipe) return;
+    fd -> pipe = NULL;
+    cli_and_save(flags);
+    if (fd -> file_pos == PIPE_READ_END) {
+        pipe -> readers--;
+        wake_up_all(&pipe -> write_wait);
+    } else {
+        pipe -> writers--;
+        wake_up_all(&pipe -> read_wait);
+    }
+    poll_wake();
+    if (!pipe -> readers && !pipe -> writers) {
+        frame_free((uint32_t)pipe -> buf);
+        kmem_cache_free(pipe_cache, pipe);
+    }
+    restore_flags(flags);
+}
+
+/* pipe_read
+ *
+ * Read what is in the pipe, up to nbytes, sleeping while it is empty
+ * Inputs: fd -- file descriptor number
+ *         buf -- the buffer that takes the read data out
+ *         nbytes -- the number of bytes the data suppose to read
+ * Outputs: Return the number read, 0 once it is empty and has no writers
+ *          Return -1 if buf is null or fd is the write end
+ * Side Effects: Wake a writer waiting for room
+ */
+int32_t pipe_read(int32_t fd, void* buf, int32_t nbytes){
+    fd_t* fda = get_fa();
+    pipe_t* pipe = fda[fd].pipe;
+    uint32_t flags = 0, wait_flags, avail, start, first;
+    int32_t shared;
+    if (!buf || nbytes < 0 || fda[fd].file_pos != PIPE_READ_END) return -1;
+    if (!nbytes) return 0;
+    // only this process can add readers, so a sole reader stays one
+    shared = pipe -> readers > 1;
+    if (shared) cli_and_save(flags);
+    while (!(avail = pipe -> head - pipe -> tail)) {
+        if (!pipe -> writers) break;
+        // recheck with interrupts off so the writer's wake up is not missed
+        cli_and_save(wait_flags);
+        if (pipe -> head == pipe -> tail && pipe -> writers) sleep_on(&pipe -> read_wait);
+        restore_flags(wait_flags);
+    }
+    if (avail > (uint32_t)nbytes) avail = nbytes;
+    start = pipe -> tail & PIPE_MASK;
+    first = PIPE_SIZE - start;
+    if (first > avail) first = avail;
+    memcpy(buf, pipe -> buf + start, first);
+    memcpy((uint8_t*)buf + first, pipe -> buf, avail - first);
+    // the bytes are out before the writer may reuse their room
+    asm volatile ("" : : : "memory");
+    pipe -> tail += avail;
+    if (shared) restore_flags(flags);
+    if (!avail) return 0;
+    if (pipe -> write_wait.head) wake_up_all(&pipe -> write_wait);
+    poll_wake();
+    return avail;
+}
+
+/* pipe_write
+ *
+ * Write all nbytes into the pipe, sleeping while it is full
+ * Inputs: fd -- file descriptor number
+ *         buf -- the data
+ *         nbytes -- its length
+ * Outputs: Return nbytes, or what was written before the last reader left
+ *          Return -1 if buf is null, fd is the read end or nothing could be
+ *          written because there is no reader
+ * Side Effects: Wake a reader waiting for data
+ */
+int32_t pipe_write(int32_t fd, const void* buf, int32_t nbytes){
+    fd_t* fda = get_fa();
+    pipe_t* pipe = fda[fd].pipe;
+    uint32_t flags = 0, wait_flags, room, start, first;
+    int32_t done = 0, shared;
+    if (!buf || nbytes < 0 || fda[fd].file_pos != PIPE_WRITE_END) return -1;
+    // only this process can add writers, so a sole writer stays one
+    shared = pipe -> writers > 1;
+    if (shared) cli_and_save(flags);
+    while (done < nbytes) {
+        if (!pipe -> readers) {
+            if (!done) done = -1;
+            break;
+        }
+        room = PIPE_SIZE - (pipe -> head - pipe -> tail);
+        if (!room) {
+            cli_and_save(wait_flags);
+            if (pipe -> head - pipe -> tail == PIPE_SIZE && pipe -> readers)
+                sleep_on(&pipe -> write_wait);
+            restore_flags(wait_flags);
+            continue;
+        }
+        if (room > (uint32_t)(nbytes - done)) room = nbytes - done;
+        start = pipe -> head & PIPE_MASK;
+        first = PIPE_SIZE - start;
+        if (first > room) first = room;
+        memcpy(pipe -> buf + start, (const uint8_t*)buf + done, first);
+        memcpy(pipe -> buf, (const uint8_t*)buf + done + first, room - first);
+        // the bytes are in before the reader may see them
+        asm volatile ("" : : : "memory");
+        pipe -> head += room;
+        done += room;
+        if (pipe -> read_wait.head) wake_up_all(&pipe -> read_wait);
+        poll_wake();
+    }
+    if (shared) restore_flags(flags);
+    return done;
+}
+
+/* pipe_poll
+ *
+ * Check whether a read or write on a pipe end would block, called with
+ * interrupts off
+ * Inputs: fd -- file descriptor number
+ * Outputs: POLLIN on the read end with data or no writers left, POLLOUT on
+ *          the write end with room or no readers left, plus POLLHUP or
+ *          POLLERR when the other end is gone
+ * Side Effects: None, reads, writes and closes wake pollers
+ */
+int32_t pipe_poll(int32_t fd){
+    fd_t* fda = get_fa();
+    pipe_t* pipe = fda[fd].pipe;
+    if (fda[fd].file_pos == PIPE_READ_END) {
+        if (!pipe -> writers) return POLLIN | POLLHUP;
+        return pipe -> head != pipe -> tail ? POLLIN : 0;
+    }
+    if (!pipe -> readers) return POLLOUT | POLLERR;
+    return pipe -> head - pipe -> tail < PIPE_SIZE ? POLLOUT : 0;
+}
+
+/* pipe_open
+ *
+ * Pipes are made by the pipe system call, not opened by name
+ */
+int32_t pipe_open(const uint8_t* filename){
+    return -1;
+}
+
+/* pipe_close
+ *
+ * Close one end of a pipe
+ * Inputs: fd -- file descriptor number
+ * Outputs: Return 0
+ * Side Effects: Drop the fd's reference on its end
+ */
+int32_t pipe_close(int32_t fd){
+    pipe_put(&get_fa()[fd]);
+    return 0;
+}
@@ -0,0 +1,49 @@
+/* pipe.h - Defines used for anonymous pipes between processes
+ */
+
+#ifndef _PIPE_H
+#define _PIPE_H
+
+#include "types.h"
+#include "x86_desc.h"
+#include "wait_queue.h"
+
+#define PIPE_SIZE       0x1000      // one frame, a power of two
+#define PIPE_MASK       (PIPE_SIZE - 1)
+#define PIPE_READ_END   0           // fd file_pos of each end
+#define PIPE_WRITE_END  1
+
+// A pipe. The writer only moves head and the reader only moves tail, so
+// one writer and one reader copy data without turning interrupts off;
+// they only do to sleep on an empty or full pipe. An end shared by several
+// fds after fork or dup2 copies with interrupts off instead, so two readers
+// or two writers cannot race on the same index. The indices only grow, a
+// byte is at index & PIPE_MASK.
+typedef struct pipe {
+    uint8_t* buf;
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    uint32_t readers;           // fds open on each end
+    uint32_t writers;
+    wait_queue_t read_wait;
+    wait_queue_t write_wait;
+} pipe_t;
+
+// Create the slab cache pipes come from
+void pipe_cache_init(void);
+
+// Make a pipe and fill two fds with its ends
+int32_t pipe_create(fd_t* read_fd, fd_t* write_fd);
+
+// Take or drop the reference an fd holds on its end
+void pipe_get(fd_t* fd);
+void pipe_put(fd_t* fd);
+
+// system calls for pipe ends
+int32_t pipe_open(const uint8_t* filename);
+int32_t pipe_close(int32_t fd);
+int32_t pipe_read(int32_t fd, void* buf, int32_t nbytes);
+int32_t pipe_write(int32_t fd, const void* buf, int32_t nbytes);
+int32_t pipe_poll(int32_t fd);
+
+#endif /* _PIPE_H */
@@ -0,0 +1,174 @@
+/* pseudo_fs.c - Functions for kernel generated files, e.g. allocator
+ * statistics that can be read with cat
+ */
+
+#include "pseudo_fs.h"
+#include "file_sys_driver.h"
+#include "pcb.h"
+#include "lib.h"
+
+typedef struct pseudo_file {
+    int8_t name[NAME_LEN + 1];
+    pseudo_show_t show;
+    pseudo_store_t store;
+} pseudo_file_t;
+
+static pseudo_file_t pseudo_files[PSEUDO_FILE_NUM];
+static uint32_t pseudo_cnt = 0;
+
+// text of the file being read, regenerated on every read
+static int8_t pseudo_text[PSEUDO_BUF_SIZE];
+
+/* pseudo_register
+ *
+ * Add a pseudo file
+ * Inputs: name -- file name, at most NAME_LEN characters
+ *         show -- fills the text of the file
+ *         store -- takes text written to the file, NULL if read-only
+ * Outputs: Return 0 for success
+ *          Return -1 if the table is full or the name is too long
+ * Side Effects: The file shows up in the directory
+ */
+int32_t pseudo_register(const int8_t* name, pseudo_show_t show, pseudo_store_t store){
+    if (pseudo_cnt >= PSEUDO_FILE_NUM || strlen(name) > NAME_LEN) return -1;
+    strncpy(pseudo_files[pseudo_cnt].name, name, NAME_LEN);
+    pseudo_files[pseudo_cnt].name[NAME_LEN] = '\0';
+    pseudo_files[pseudo_cnt].show = show;
+    pseudo_files[pseudo_cnt].store = store;
+    pseudo_cnt++;
+    return 0;
+}
+
+/* pseudo_dentry_by_index
+ *
+ * Make the dentry of a pseudo file, the inode number is its index
+ * Inputs: index -- index of the pseudo file
+ *         dentry -- saves the dentry
+ * Outputs: Return 0 for success
+ *          Return -1 for index is invalid
+ * Side Effects: Save the dentry
+ */
+int32_t pseudo_dentry_by_index(uint32_t index, dentry_t* dentry){
+    if (index >= pseudo_cnt) return -1;
+    memset(dentry, 0, sizeof(dentry_t));
+    strncpy(dentry->filename, pseudo_files[index].name, NAME_LEN);
+    dentry->filetype = PSEUDO_TYPE;
+    dentry->inode_num = index;
+    return 0;
+}
+
+/* pseudo_dentry_by_name
+ *
+ * Find a pseudo file by name
+ * Inputs: fname -- the name of the target file
+ *         dentry -- saves the dentry
+ * Outputs: Return 0 for success
+ *          Return -1 for cannot find the name
+ * Side Effects: Save the dentry
+ */
+int32_t pseudo_dentry_by_name(const uint8_t* fname, dentry_t* dentry){
+    uint32_t i;
+    if (!fname) return -1;
+    for (i = 0; i < pseudo_cnt; i++) {
+        if (!strncmp(pseudo_files[i].name, (const int8_t*)fname, NAME_LEN + 1))
+            return pseudo_dentry_by_index(i, dentry);
+    }
+    return -1;
+}
+
+/* pseudo_puts
+ *
+ * Append a string to the text, cut at the buffer size
+ * Inputs: out -- text being built
+ *         str -- string to append
+ * Outputs: None
+ * Side Effects: Advance out->len
+ */
+void pseudo_puts(pseudo_buf_t* out, const int8_t* str){
+    while (*str && out->len < out->size) out->buf[out->len++] = *str++;
+}
+
+/* pseudo_putu
+ *
+ * Append an unsigned number, right aligned in width columns
+ * Inputs: out -- text being built
+ *         value -- number to append
+ *         width -- minimum width, padded with spaces
+ * Outputs: None
+ * Side Effects: Advance out->len
+ */
+void pseudo_putu(pseudo_buf_t* out, uint32_t value, int32_t width){
+    int8_t num[PSEUDO_NUM_LEN];
+    int32_t pad;
+    itoa(value, num, 10);
+    for (pad = width - (int32_t)strlen(num); pad > 0; pad--) pseudo_puts(out, " ");
+    pseudo_puts(out, num);
+}
+
+/* pseudo_open
+ *
+ * Open a pseudo file
+ * Do nothing specificly inside.
+ */
+int32_t pseudo_open(const uint8_t* filename){
+    return 0;
+}
+
+/* pseudo_close
+ *
+ * Close a pseudo file
+ * Do nothing specificly inside.
+ */
+int32_t pseudo_close(int32_t fd){
+    return 0;
+}
+
+/* pseudo_read
+ *
+ * Generate the text of a pseudo file and copy out the part after the
+ * file position, so a file can be read in pieces like a regular one
+ * Inputs: fd -- file descriptor number
+ *         buf -- the buffer that takes the read data out
+ *         nbytes -- the number of bytes the data suppose to read
+ * Outputs: Return the number read, 0 at the end of the text
+ *          Return -1 if buf is null
+ * Side Effects: Advance the file position
+ */
+int32_t pseudo_read(int32_t fd, void* buf, int32_t nbytes){
+    fd_t* fda = get_fa();
+    pseudo_buf_t out;
+    uint32_t flags;
+    int32_t len;
+    if (!buf || nbytes < 0 || fda[fd].inode_idx >= pseudo_cnt) return -1;
+    out.buf = pseudo_text;
+    out.len = 0;
+    out.size = PSEUDO_BUF_SIZE;
+    cli_and_save(flags);
+    pseudo_files[fda[fd].inode_idx].show(&out);
+    len = out.len - fda[fd].file_pos;
+    if (len < 0) len = 0;
+    if (len > nbytes) len = nbytes;
+    memcpy(buf, pseudo_text + fda[fd].file_pos, len);
+    restore_flags(flags);
+    fda[fd].file_pos += len;
+    return len;
+}
+
+/* pseudo_write
+ *
+ * Hand written text to the file's store function
+ * Inputs: fd -- file descriptor number
+ *         buf -- the text
+ *         nbytes -- its length
+ * Outputs: Return what store returns
+ *          Return -1 if buf is null or the file is read-only
+ * Side Effects: Depends on the file
+ */
+int32_t pseudo_write(int32_t fd, const void* buf, int32_t nbytes){
+    fd_t* fda = get_fa();
+    pseudo_store_t store;
+    if (!buf || nbytes <= 0 || fda[fd].inode_idx >= pseudo_cnt) return -1;
+    store = pseudo_files[fda[fd].inode_idx].store;
+    if (!store) return -1;
+    return store((const int8_t*)buf, nbytes);
+}
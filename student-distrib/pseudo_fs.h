@@ -0,0 +1,45 @@
+/* pseudo_fs.h - Defines used for kernel generated files
+ */
+
+#ifndef _PSEUDO_FS_H
+#define _PSEUDO_FS_H
+
+#include "types.h"
+#include "x86_desc.h"
+
+#define PSEUDO_TYPE         3       // dentry file type of a pseudo file
+#define PSEUDO_FILE_NUM     8       // pseudo files that can be registered
+#define PSEUDO_BUF_SIZE     2048    // largest text a pseudo file can show
+#define PSEUDO_NUM_LEN      12      // digits of a 32 bit number and the sign
+
+// Text being built for a read of a pseudo file
+typedef struct pseudo_buf {
+    int8_t* buf;
+    int32_t len;
+    int32_t size;
+} pseudo_buf_t;
+
+// Fill the whole text of a pseudo file
+typedef void (*pseudo_show_t)(pseudo_buf_t* out);
+// Take a setting written to a pseudo file, returns bytes taken or -1
+typedef int32_t (*pseudo_store_t)(const int8_t* buf, int32_t nbytes);
+
+// Add a file that lists in the directory and shows text generated on read,
+// store is NULL for a read-only file
+int32_t pseudo_register(const int8_t* name, pseudo_show_t show, pseudo_store_t store);
+
+// Dentries of pseudo files, following the filesystem image ones
+int32_t pseudo_dentry_by_name(const uint8_t* fname, dentry_t* dentry);
+int32_t pseudo_dentry_by_index(uint32_t index, dentry_t* dentry);
+
+// Append to the text of a pseudo file
+void pseudo_puts(pseudo_buf_t* out, const int8_t* str);
+void pseudo_putu(pseudo_buf_t* out, uint32_t value, int32_t width);
+
+// system calls for pseudo files
+int32_t pseudo_open(const uint8_t* filename);
+int32_t pseudo_close(int32_t fd);
+int32_t pseudo_read(int32_t fd, void* buf, int32_t nbytes);
+int32_t pseudo_write(int32_t fd, const void* buf, int32_t nbytes);
+
+#endif /* _PSEUDO_FS_H */
@@ -0,0 +1,45 @@
+#!/bin/bash
+
+# Boot bootimg and bootimg-release in QEMU with "bench" on the command line
+# and compare the cycle counts they print on the debug console. Build bootimg
+# with make first; bootimg-release is built here.
+
+QEMU=${QEMU:-qemu-system-i386}
+TIMEOUT=${TIMEOUT:-120}
+LOG_DIR=${LOG_DIR:-/tmp}
+
+cd "$(dirname "$0")"
+
+if ! command -v $QEMU > /dev/null; then
+    echo "$QEMU not found, set QEMU to the emulator to use"
+    exit 1
+fi
+if [ ! -f bootimg ]; then
+    echo "bootimg not found, run make first"
+    exit 1
+fi
+make bootimg-release || exit 1
+
+# run_bench image log
+run_bench() {
+    rm -f $2
+    timeout $TIMEOUT $QEMU -m 256 -display none -no-reboot \
+        -kernel $1 -initrd filesys_img -append bench \
+        -debugcon file:$2 -device isa-debug-exit,iobase=0xf4,iosize=0x04
+    if ! grep -q "All benchmarks executed" $2 || grep -q "Result = FAIL" $2; then
+        echo "$1 failed the benchmarks, see $2"
+        exit 1
+    fi
+}
+
+# "name|cycles" for every "name: N cycles/unit" line of a log
+cycles() {
+    sed -n 's/^ *\([^:]*[^ :]\): *\([0-9][0-9]*\) cycles\/.*/\1|\2/p' $1 | sort -t'|' -k1,1
+}
+
+run_bench bootimg $LOG_DIR/bench-debug.log
+run_bench bootimg-release $LOG_DIR/bench-release.log
+
+printf "%-28s %10s %10s %8s\n" benchmark debug release speedup
+join -t'|' <(cycles $LOG_DIR/bench-debug.log) <(cycles $LOG_DIR/bench-release.log) |
+    awk -F'|' '{ printf "%-28s %10d %10d %7.2fx\n", $1, $2, $3, $3 ? $2 / $3 : 0 }'
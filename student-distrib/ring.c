@@ -0,0 +1,117 @@
+/* ring.c - Functions used to batch system calls through a ring shared
+ * with the user program
+ */
+
+#include "ring.h"
+#include "system_call.h"
+#include "pcb.h"
+#include "task.h"
+#include "paging_init.h"
+#include "loader.h"
+#include "lib.h"
+
+/* ring_page_in_image
+ *
+ * Check whether a segment of the running program covers the ring page, in
+ * which case it is the program's own memory even before it is touched
+ * Inputs: pcb -- the process
+ * Outputs: Return 1 if a segment overlaps the page, 0 if not
+ * Side Effects: None
+ */
+static int32_t ring_page_in_image(const pcb_t* pcb){
+    uint32_t i;
+    const exec_seg_t* seg;
+    for (i = 0; i < pcb -> exec.seg_cnt; i++) {
+        seg = &pcb -> exec.segs[i];
+        if (seg -> vaddr < USER_RING_ADDR + USER_PG_SIZE && seg -> vaddr + seg -> memsz > USER_RING_ADDR) return 1;
+    }
+    return 0;
+}
+
+/* sys_ring_setup
+ *
+ * Map the ring page at USER_RING_ADDR in the current process and clear it,
+ * or hand back the one it already has
+ * Inputs: ring -- where to save the user address of the ring
+ * Outputs: Return 0 on success
+ *          Return -1 for a bad pointer, if memory is exhausted or if the
+ *          program already uses the page, which is never overwritten
+ * Side Effects: map a page; a forked child shares its parent's ring
+ *               copy-on-write
+ */
+int32_t sys_ring_setup(ring_t** ring){
+    pcb_t* cur_pcb;
+    pte_t* pte;
+    uint32_t flags;
+    if (!ring) return -1;
+    // the pointer has to be in the user program page
+    if ((uint32_t)ring < USER_PG_START || (uint32_t)ring > USER_PG_END - sizeof(ring_t*)) return -1;
+    cur_pcb = get_pcb();
+    if (!cur_pcb -> ring) {
+        pte = &user_page_table[cur_pcb -> current_id][(USER_RING_ADDR - USER_PG_START) >> SHIFT_OFF];
+        if (ring_page_in_image(cur_pcb)) return -1;
+        cli_and_save(flags);
+        // a page the program touched, its stack or data, is not ours to clear
+        if (pte -> present || task_map_page(cur_pcb -> current_id, USER_RING_ADDR)) {
+            restore_flags(flags);
+            return -1;
+        }
+        restore_flags(flags);
+        memset((void*)USER_RING_ADDR, 0, sizeof(ring_t));
+        cur_pcb -> ring = (ring_t*)USER_RING_ADDR;
+    }
+    *ring = cur_pcb -> ring;
+    return 0;
+}
+
+/* ring_op
+ *
+ * Run one submission through the system call it names, so it goes through
+ * the same checks and file_op_table dispatch as a trap would
+ * Inputs: sqe -- copy of the submission
+ * Outputs: the return value of the system call, -1 for an unknown op
+ * Side Effects: those of the system call
+ */
+static int32_t ring_op(const ring_sqe_t* sqe){
+    switch (sqe -> op) {
+        case RING_OP_READ:
+            return sys_read(sqe -> fd, (void*)sqe -> buf, sqe -> nbytes);
+        case RING_OP_WRITE:
+            return sys_write(sqe -> fd, (const void*)sqe -> buf, sqe -> nbytes);
+        case RING_OP_OPEN:
+            return sys_open((const uint8_t*)sqe -> buf);
+        case RING_OP_CLOSE:
+            return sys_close(sqe -> fd);
+        default:
+            return -1;
+    }
+}
+
+/* sys_ring_enter
+ *
+ * Run the queued submissions in order, each leaving a completion. Stops
+ * early when the completion queue is full.
+ * Inputs: None
+ * Outputs: Return the number of submissions run
+ *          Return -1 if the process has no ring
+ * Side Effects: those of the system calls run, advance sq_head and cq_tail
+ */
+int32_t sys_ring_enter(void){
+    ring_t* ring = get_pcb() -> ring;
+    ring_sqe_t sqe;
+    ring_cqe_t* cqe;
+    int32_t done = 0;
+    if (!ring) return -1;
+    while (ring -> sq_head != ring -> sq_tail) {
+        if (ring -> cq_tail - ring -> cq_head >= RING_ENTRIES) break;
+        // copy it, the program may reuse the slot once sq_head moves
+        sqe = ring -> sq[ring -> sq_head & RING_MASK];
+        ring -> sq_head++;
+        cqe = &ring -> cq[ring -> cq_tail & RING_MASK];
+        cqe -> res = ring_op(&sqe);
+        cqe -> user_data = sqe.user_data;
+        ring -> cq_tail++;
+        done++;
+    }
+    return done;
+}
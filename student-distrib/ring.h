@@ -0,0 +1,53 @@
+/* ring.h - Defines used to batch system calls through a ring shared with
+ * the user program
+ */
+
+#ifndef _RING_H
+#define _RING_H
+
+#include "types.h"
+
+#define USER_RING_ADDR  0x8200000   // page in the user program page, middle of the 4MB
+#define RING_ENTRIES    64          // entries in each queue, a power of two
+#define RING_MASK       (RING_ENTRIES - 1)
+
+// operations, each runs the system call of the same name
+#define RING_OP_READ    1
+#define RING_OP_WRITE   2
+#define RING_OP_OPEN    3
+#define RING_OP_CLOSE   4
+
+// Submission entry, filled by the program
+typedef struct ring_sqe {
+    int32_t op;
+    int32_t fd;
+    uint32_t buf;           // buffer, or the file name for open
+    int32_t nbytes;
+    uint32_t user_data;     // copied to the completion
+} ring_sqe_t;
+
+// Completion entry, filled by the kernel
+typedef struct ring_cqe {
+    int32_t res;            // what the system call returned
+    uint32_t user_data;
+} ring_cqe_t;
+
+// The shared page. The program writes entries and advances sq_tail, the
+// kernel advances sq_head and cq_tail, the program advances cq_head. The
+// indices only grow, an entry is at index & RING_MASK.
+typedef struct ring {
+    uint32_t sq_head;
+    uint32_t sq_tail;
+    uint32_t cq_head;
+    uint32_t cq_tail;
+    ring_sqe_t sq[RING_ENTRIES];
+    ring_cqe_t cq[RING_ENTRIES];
+} ring_t;
+
+// Map the ring page of the current process
+int32_t sys_ring_setup(ring_t** ring);
+
+// Run every queued submission while there is room for its completion
+int32_t sys_ring_enter(void);
+
+#endif /* _RING_H */
@@ -6,6 +6,8 @@
 #include "lib.h"
 #include "x86_desc.h"
 #include "pcb.h"
+#include "wait_queue.h"
+#include "scheduler.h"
 
 #include "signal.h"
 
@@ -15,7 +17,11 @@
 volatile int interrupt_flag = 0;
 
 // Virualized RTC Counter
-int32_t tick_counter = 0;
+volatile int32_t tick_counter = 0;
+
+// readers waiting for a tick, and the earliest tick one of them waits for
+static wait_queue_t rtc_wait;
+static int32_t rtc_wake_tick = RTC_NO_WAKE;
 
 // global counter to trigger ALARM signal once every 10 seconds
 // cleared everytime when change_rate() is called, and increments everytime rtc_handler is triggered
@@ -59,12 +65,20 @@ void rtc_handler() {
     // Using Virtualized RTC
     tick_counter++;
     interrupt_flag = 1;
+    // readers whose tick has not come yet go back to sleep
+    if (tick_counter >= rtc_wake_tick) {
+        rtc_wake_tick = RTC_NO_WAKE;
+        wake_up_all(&rtc_wait);
+        poll_wake();
+    }
     #ifdef TEST_EXTRA
     if (tick_counter % (RTC_FREQ_MAX * SIG_INTERVAL) == 0) signal_generate(ALARM);
     #endif
     // Throw away the data saved in register C
     outb(0x0C, RTC_PORT);
     inb(RTC_DATA);
+    // a woken reader may outrank the interrupted process
+    sched_preempt();
 }
 
 /* rtc_open
@@ -86,13 +100,40 @@ int32_t rtc_open(const uint8_t* fname){
  */
 int32_t rtc_close(int32_t fd){
     fd_t* fda = get_fa();
-    fda[fd].file_pos = RTC_FREQ_MAX / RTC_FREQ_MIN / TER_NUM;
+    fda[fd].file_pos = RTC_FREQ_MAX / RTC_FREQ_MIN;
     return 0;
 }
 
+/* rtc_wake_at
+ *
+ * Make the handler wake sleepers once the counter reaches a tick, call
+ * with interrupts off
+ * Inputs: tick -- value of tick_counter to wake at
+ * Outputs: None
+ * Side Effects: may move the wake tick earlier
+ */
+void rtc_wake_at(int32_t tick){
+    if (tick < rtc_wake_tick) rtc_wake_tick = tick;
+}
+
+/* rtc_next_tick
+ *
+ * The virtualized interrupt an fd waits for: the first multiple of its
+ * interval after its last read
+ * Inputs: fd -- file descriptor
+ * Outputs: value of tick_counter it fires at
+ * Side Effects: None
+ */
+static int32_t rtc_next_tick(int32_t fd){
+    fd_t* fda = get_fa();
+    return (fda[fd].inode_idx / fda[fd].file_pos + 1) * fda[fd].file_pos;
+}
+
 /* rtc_read
  *
- * RTC read blocks the program until an virtualized interrupt is received
+ * RTC read blocks the program until an virtualized interrupt is received,
+ * sleeping so other processes get the cpu. One that came since the last
+ * read is returned at once, like the pending flag of the real RTC.
  * Inputs: fd -- file descriptor
  *         buf -- Not used
  *         nbytes -- Not used
@@ -101,12 +142,34 @@ int32_t rtc_close(int32_t fd){
  */
 int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes){
     fd_t* fda = get_fa();
-    while(!interrupt_flag);
-    while(tick_counter % fda[fd].file_pos != 0);
+    uint32_t flags;
+    int32_t target;
+    cli_and_save(flags);
+    target = rtc_next_tick(fd);
+    while(tick_counter < target) {
+        rtc_wake_at(target);
+        sleep_on(&rtc_wait);
+    }
+    fda[fd].inode_idx = tick_counter;
     interrupt_flag = 0;
+    restore_flags(flags);
     return 0;
 }
 
+/* rtc_poll
+ *
+ * Check whether a read would block, called with interrupts off
+ * Inputs: fd -- file descriptor
+ * Outputs: POLLOUT, and POLLIN once the virtualized interrupt came
+ * Side Effects: have the handler wake pollers when it comes
+ */
+int32_t rtc_poll(int32_t fd){
+    int32_t target = rtc_next_tick(fd);
+    if (tick_counter >= target) return POLLIN | POLLOUT;
+    rtc_wake_at(target);
+    return POLLOUT;
+}
+
 /* rtc_write
  *
  * RTC write writes a new frequency.
@@ -125,7 +188,7 @@ int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes){
     // Check if freq is in correct range and is the power of 2
     if (freq_to_write > RTC_FREQ_MAX || freq_to_write < RTC_FREQ_MIN || (freq_to_write & (freq_to_write - 1)) != 0) return -1;
     // Using virtualized RTC
-    fda[fd].file_pos = RTC_FREQ_MAX / freq_to_write / TER_NUM;
+    fda[fd].file_pos = RTC_FREQ_MAX / freq_to_write;
     return 0;
 }
 
@@ -19,6 +19,11 @@
 #define RTC_FREQ_MAX    1024
 #define RTC_FREQ_MIN    2
 #define SIG_INTERVAL    10
+#define RTC_NO_WAKE     0x7FFFFFFF  // no reader is sleeping
+
+// Virtualized RTC counter, incremented on every RTC interrupt
+extern volatile int32_t tick_counter;
+
 // Enable RTC interrrupt on PIC
 void rtc_init();
 
@@ -33,6 +38,10 @@ int32_t rtc_open(const uint8_t* fname);
 int32_t rtc_close(int32_t fd);
 int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes);
 int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes);
+int32_t rtc_poll(int32_t fd);
+
+// Wake sleepers and pollers once tick_counter reaches tick
+void rtc_wake_at(int32_t tick);
 
 // Change the rate of RTC
 void change_rate(int rate);
@@ -7,10 +7,43 @@
 #include "task.h"
 #include "paging_init.h"
 #include "keyboard.h"
+#include "terminal_driver.h"
+#include "pseudo_fs.h"
 
 // pit interrupt counter 
 uint32_t pit_cnt = 0;
 
+// one FIFO run queue per priority and a bit for each one that is not
+// empty; the running process is not queued
+static pcb_t* run_head[SCHED_PRIO_NUM];
+static pcb_t* run_tail[SCHED_PRIO_NUM];
+static uint32_t run_bitmap = 0;
+static pcb_t* sched_cur = NULL;         // process owning the cpu, NULL at boot
+static pcb_t* sched_last = NULL;        // last process other than idle to run
+static uint32_t switch_cnt = 0;         // context switches done
+static uint32_t switch_cycles = 0;      // cycles spent in them
+static uint32_t tick_cycles = 0;        // cycles from a tick to the next process
+static uint32_t tick_start = 0;         // tsc of the tick being handled, 0 if none
+static uint32_t sched_quantum = SCHED_QUANTUM_DEFAULT;
+static uint32_t slice_ticks = 0;        // ticks the running process has had
+
+// The idle task runs when nothing else is runnable. It only ever runs in
+// the kernel, on its own stack, and is never on the run queue. The pcb
+// pointer at the base of the stack lets get_pcb work in interrupts it takes.
+static pcb_t idle_pcb;
+static uint32_t idle_stack[KB_8 / sizeof(uint32_t)] __attribute__((aligned(KB_8)));
+
+// Tickless: while at most one process is runnable there is no slice to
+// end, so the PIT runs one-shot for the longest time it can count instead
+static uint32_t pit_mode = PIT_PERIODIC;
+static uint32_t pit_oneshot_count = 0;  // clocks the one-shot was armed for
+static uint32_t pit_clocks = 0;         // clocks not yet a whole tick
+static uint32_t pit_irq_cnt = 0;        // timer interrupts taken
+
+static void sched_start(void);
+static void sched_show(pseudo_buf_t* out);
+static int32_t sched_store(const int8_t* buf, int32_t nbytes);
+
 /* pit_init
  *
  * Initiate PIT
@@ -26,98 +59,552 @@ void pit_init(){
     // 1193182 / 100 = 11931
     outb(LOFREQ, PIT_DATA);
     outb(HIFREQ, PIT_DATA);
+    pit_mode = PIT_PERIODIC;
     // enable irq0
     enable_irq(PIT_IRQ);
     pit_cnt = 0;
+    (void)pseudo_register("sched", sched_show, sched_store);
     sti();
     return;
 }
 
+/* pit_charge
+ *
+ * Turn elapsed PIT clocks into ticks of pit_cnt, charged to the running
+ * process or the idle task
+ * Inputs: clocks -- input clocks elapsed
+ * Outputs: None
+ * Side Effects: advance pit_cnt
+ */
+static void pit_charge(uint32_t clocks){
+    uint32_t ticks;
+    pit_clocks += clocks;
+    ticks = pit_clocks / PIT_RELOAD;
+    pit_clocks %= PIT_RELOAD;
+    pit_cnt += ticks;
+    slice_ticks += ticks;
+    if (sched_cur && ticks) {
+        sched_cur -> run_ticks += ticks;
+        // ran through a tick, it is using the cpu rather than waiting on I/O
+        sched_cur -> boost = 0;
+    }
+}
+
+/* pit_elapsed
+ *
+ * Clocks since the counter was last loaded, read by latching it
+ * Inputs: None
+ * Outputs: elapsed input clocks
+ * Side Effects: None
+ */
+static uint32_t pit_elapsed(void){
+    uint32_t load = (pit_mode == PIT_ONESHOT) ? pit_oneshot_count : PIT_RELOAD;
+    uint32_t count;
+    outb(PIT_LATCH_CMD, PIT_PORT);
+    count = inb(PIT_DATA);
+    count |= inb(PIT_DATA) << 8;
+    // a one-shot that just ran out has wrapped around
+    return count > load ? load : load - count;
+}
+
+/* pit_update
+ *
+ * Tick periodically while processes wait in the run queue, otherwise arm
+ * the longest one-shot. The time already counted down is charged before
+ * the counter is reloaded.
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: reprogram PIT channel 0, call with interrupts off
+ */
+static void pit_update(void){
+    if (run_bitmap) {
+        if (pit_mode == PIT_PERIODIC) return;
+        if (pit_mode == PIT_ONESHOT) pit_charge(pit_elapsed());
+        outb(PIT_CMD, PIT_PORT);
+        outb(LOFREQ, PIT_DATA);
+        outb(HIFREQ, PIT_DATA);
+        pit_mode = PIT_PERIODIC;
+    } else {
+        if (pit_mode == PIT_ONESHOT) return;
+        if (pit_mode == PIT_PERIODIC) pit_charge(pit_elapsed());
+        pit_oneshot_count = PIT_RELOAD * PIT_IDLE_TICKS;
+        outb(PIT_ONESHOT_CMD, PIT_PORT);
+        outb(pit_oneshot_count & BYTE_MASK, PIT_DATA);
+        outb(pit_oneshot_count >> 8, PIT_DATA);
+        pit_mode = PIT_ONESHOT;
+    }
+}
+
+/* tick_done
+ *
+ * Charge the time since the tick came in to scheduling overhead, once per
+ * tick, when the cpu is handed to a process
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: None
+ */
+static void tick_done(void){
+    if (!tick_start) return;
+    tick_cycles += rdtsc_low() - tick_start;
+    tick_start = 0;
+}
+
 /* pit_handler
  *
  * pit interrupt handler
  * Inputs: None
  * Outputs: None
- * Side Effects: increase tick count, call switch process
+ * Side Effects: increase tick count, charge the ticks to the running
+ *               process, idle included, and preempt it
  */
 void pit_handler(){    
     // send_eoi
     send_eoi(PIT_IRQ);
-    // calculate next terminal to schedule
-    uint32_t next_ter = pit_cnt % TER_NUM;
-    pit_cnt ++;
     cli();
-    // swich process
-    switch_process(next_ter);
+    tick_start = rdtsc_low();
+    pit_irq_cnt ++;
+    if (pit_mode == PIT_ONESHOT) {
+        pit_mode = PIT_STOPPED;
+        pit_charge(pit_oneshot_count);
+    } else {
+        pit_charge(PIT_RELOAD);
+    }
+    if (get_process_cnt()==0) {
+        tick_start = 0;
+        sched_start();
+        return;
+    }
+    // a process only loses the cpu to its peers once its slice is used up
+    if (slice_ticks >= sched_quantum) schedule();
+    else sched_preempt();
+    // schedule rearms the timer when it switches, not when it keeps going
+    pit_update();
+    tick_done();
     sti();
 }
 
+/* idle_loop
+ *
+ * Body of the idle task: halt until an interrupt, and give the cpu away as
+ * soon as a process is runnable
+ * Inputs: None
+ * Outputs: None, never returns
+ * Side Effects: None
+ */
+static void idle_loop(void){
+    while (1) {
+        cli();
+        if (run_bitmap) schedule();
+        // sti takes effect after hlt, so a wake up cannot slip in between
+        else asm volatile("sti; hlt" : : : "memory");
+    }
+}
 
-/* switch process
+/* idle_init
  *
- * save current stack and switch to the next scheduling process
- * Inputs: next_ter -- the upcomming terminal number
+ * Set up the idle task so the first switch to it enters idle_loop
+ * Inputs: None
  * Outputs: None
- * Side Effects: save stack, switch paging and switch process
+ * Side Effects: write the idle stack
  */
-void switch_process(uint32_t next_ter){
-    cli();
-    if (get_process_cnt()==0) execute_shell(0);
-    uint8_t next_pid = terminal_pid[next_ter];
-    // get current process's pcb
-    pcb_t* cur_pcb = get_pcb_by_id(active_process);
-    // save esp ebp
-    uint32_t esp,ebp;
-    asm volatile("                      \n\
-            movl %%ebp,%0               \n\
-            movl %%esp,%1               \n\
-        "
-        : "=r"(ebp), "=r"(esp)
-        : 
-        : "memory"
-    );
-    cur_pcb->stack_switch_bp=ebp;
-    cur_pcb->stack_switch_p=esp;
+static void idle_init(void){
+    uint32_t* top = &idle_stack[KB_8 / sizeof(uint32_t)];
+    memset(&idle_pcb, 0, sizeof(idle_pcb));
+    idle_pcb.current_id = -1;
+    idle_pcb.kernel_stack = (uint32_t)idle_stack;
+    idle_pcb.state = TASK_RUNNABLE;
+    idle_pcb.start_tick = pit_cnt;
+    idle_stack[0] = (uint32_t)&idle_pcb;
+    // a return address for idle_loop, which never uses it, then the one
+    // switch_to returns to and the registers it pops
+    top[-1] = 0;
+    top[-2] = (uint32_t)idle_loop;
+    memset(&top[-2 - SWITCH_SAVED_REGS], 0, SWITCH_SAVED_REGS * sizeof(uint32_t));
+    idle_pcb.stack_switch_p = (uint32_t)&top[-2 - SWITCH_SAVED_REGS];
+}
+
+/* sched_start
+ *
+ * Start a shell on every terminal and switch to the first one. Called on
+ * the first tick, the boot stack is dropped.
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: create the shells and run them
+ */
+static void sched_start(void){
+    uint32_t ter;
+    clear_terminal();
+    // initialize to -1 to indicate no process running
+    for (ter = 0; ter < TER_NUM; ter++) terminal_pid[ter] = -1;
+    idle_init();
+    for (ter = 0; ter < TER_NUM; ter++) (void)execute_shell(ter);
+    schedule();
+}
+
+/* sched_prio
+ *
+ * Priority a process is queued at: a process woken from I/O is boosted
+ * one level until it runs through a whole tick
+ * Inputs: pcb -- the process
+ * Outputs: effective priority, 0 is the highest
+ * Side Effects: None
+ */
+static uint32_t sched_prio(pcb_t* pcb){
+    if (pcb -> boost && pcb -> priority > 0) return pcb -> priority - 1;
+    return pcb -> priority;
+}
+
+/* run_first
+ *
+ * Head of the highest priority run queue that is not empty, found with
+ * bsf on the bitmap of non-empty queues
+ * Inputs: None
+ * Outputs: the process to run next, NULL if nothing is runnable
+ * Side Effects: None
+ */
+static pcb_t* run_first(void){
+    uint32_t level;
+    if (!run_bitmap) return NULL;
+    asm ("bsfl %1, %0" : "=r"(level) : "rm"(run_bitmap));
+    return run_head[level];
+}
+
+/* run_enqueue
+ *
+ * Add a process at the tail of the run queue of its priority
+ * Inputs: pcb -- the process, not on the run queue
+ * Outputs: None
+ * Side Effects: change the run queue, call with interrupts off
+ */
+static void run_enqueue(pcb_t* pcb){
+    uint32_t level = sched_prio(pcb);
+    pcb -> enqueue_tsc = rdtsc_low();
+    pcb -> run_level = level;
+    pcb -> run_next = NULL;
+    pcb -> run_prev = run_tail[level];
+    if (run_tail[level]) run_tail[level] -> run_next = pcb;
+    else run_head[level] = pcb;
+    run_tail[level] = pcb;
+    run_bitmap |= 1 << level;
+    // someone is waiting now, the running process gets a slice
+    pit_update();
+}
+
+/* sched_wake
+ *
+ * Make a blocked process runnable, at the tail of the run queue
+ * Inputs: pcb -- the process
+ * Outputs: None
+ * Side Effects: change the run queue, call with interrupts off
+ */
+void sched_wake(pcb_t* pcb){
+    if (pcb -> state == TASK_RUNNABLE) return;
+    pcb -> state = TASK_RUNNABLE;
+    // the running process is queued by schedule when it gives up the cpu
+    if (pcb != sched_cur) run_enqueue(pcb);
+}
+
+/* sched_run_next
+ *
+ * Make a process runnable at the head of the run queue of its priority,
+ * so it runs on the next schedule. Used to hand the cpu to a child that was just executed.
+ * Inputs: pcb -- the process, not on the run queue
+ * Outputs: None
+ * Side Effects: change the run queue, call with interrupts off
+ */
+void sched_run_next(pcb_t* pcb){
+    uint32_t level = sched_prio(pcb);
+    pcb -> state = TASK_RUNNABLE;
+    pcb -> enqueue_tsc = rdtsc_low();
+    pcb -> run_level = level;
+    pcb -> run_prev = NULL;
+    pcb -> run_next = run_head[level];
+    if (run_head[level]) run_head[level] -> run_prev = pcb;
+    else run_tail[level] = pcb;
+    run_head[level] = pcb;
+    run_bitmap |= 1 << level;
+    pit_update();
+}
+
+/* sched_dequeue
+ *
+ * Take a process off the run queue if it is on it
+ * Inputs: pcb -- the process
+ * Outputs: None
+ * Side Effects: change the run queue, call with interrupts off
+ */
+void sched_dequeue(pcb_t* pcb){
+    uint32_t level = pcb -> run_level;
+    if (level >= SCHED_PRIO_NUM) return;
+    if (pcb -> run_prev) pcb -> run_prev -> run_next = pcb -> run_next;
+    else run_head[level] = pcb -> run_next;
+    if (pcb -> run_next) pcb -> run_next -> run_prev = pcb -> run_prev;
+    else run_tail[level] = pcb -> run_prev;
+    if (!run_head[level]) run_bitmap &= ~(1 << level);
+    pcb -> run_next = NULL;
+    pcb -> run_prev = NULL;
+    pcb -> run_level = SCHED_PRIO_NUM;
+}
+
+/* switch_account
+ *
+ * Count a switch away from a process and the time it took to decide it
+ * Inputs: cur -- the process losing the cpu, NULL at boot
+ *         start -- tsc when schedule was entered
+ * Outputs: None
+ * Side Effects: None
+ */
+static void switch_account(pcb_t* cur, uint32_t start){
+    if (cur) {
+        if (cur -> state == TASK_RUNNABLE) cur -> nivcsw ++;
+        else cur -> nvcsw ++;
+    }
+    switch_cnt ++;
+    switch_cycles += rdtsc_low() - start;
+    tick_done();
+}
+
+/* schedule
+ *
+ * Put the current process back on the run queue if it is still runnable and
+ * switch to the process at the head, or to the idle task if there is none.
+ * A process that blocked or died is just left off the queue.
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: switch video paging, then switch_to saves the current
+ *               process and loads the next one. Call with interrupts off,
+ *               returns with them off when the caller is scheduled again.
+ */
+void schedule(void){
+    pcb_t* cur = sched_cur;
+    pcb_t* next;
+    uint32_t start, now;
+    start = rdtsc_low();
+    if (cur && cur != &idle_pcb && cur -> state == TASK_RUNNABLE) {
+        // nobody as important is waiting, keep running
+        next = run_first();
+        if (next == NULL || sched_prio(next) > sched_prio(cur)) return;
+        run_enqueue(cur);
+    }
+    next = run_first();
+    if (next == NULL) {
+        if (cur == &idle_pcb) return;
+        pit_update();
+        // idle keeps the loaded directory and esp0, it never enters user mode
+        sched_cur = &idle_pcb;
+        idle_pcb.run_cnt ++;
+        slice_ticks = 0;
+        switch_account(cur, start);
+        switch_to(cur ? &cur -> stack_switch_p : NULL, idle_pcb.stack_switch_p,
+                  tss.esp0, getPageDirectory());
+        return;
+    }
+    sched_dequeue(next);
+    pit_update();
+    now = rdtsc_low();
+    next -> run_cnt ++;
+    next -> wait_cycles += now - next -> enqueue_tsc;
+    next -> last_tick = pit_cnt;
+    slice_ticks = 0;
+    if (next == cur) return;
 
     // now start switching
-    active_process = next_pid;
+    sched_cur = next;
+    active_process = next -> current_id;
     // switch video paging
-    if(next_ter == active_ter){
+    if(next -> terminal == active_ter){
         video_mem_page_table[VIDEO_START_OFF].addr = VIDEO_START_OFF;
         user_video_page_table[VIDEO_START_OFF].addr = VIDEO_START_OFF;
     }else{
-        video_mem_page_table[VIDEO_START_OFF].addr = VIDEO_START_OFF + next_ter + 1;
-        user_video_page_table[VIDEO_START_OFF].addr = VIDEO_START_OFF + next_ter + 1;
+        video_mem_page_table[VIDEO_START_OFF].addr = VIDEO_START_OFF + next -> terminal + 1;
+        user_video_page_table[VIDEO_START_OFF].addr = VIDEO_START_OFF + next -> terminal + 1;
     }
-    flushTLB();
+    invalidatePage(VIDEO_MEM_ADDR);
+    invalidatePage(USER_VIDEO_V_ADDR);
     // update cursor and screen x_y 
-    switch_process_cursor(cur_pcb->terminal,next_ter);
-    if(next_pid == (uint8_t)-1){
-        execute_shell(next_ter);
-    }else{
-        pcb_t* next_pcb = get_pcb_by_id(active_process);
-
-        // switch paging
-        uint32_t offset =  (MB_8 + active_process * MB_4) >> SHIFT_OFF;
-        page_directory[MB_128_V_OFF].addr = offset;        
-        flushTLB();
-
-        // fetch new esp and ebp
-        esp = next_pcb -> stack_switch_p;
-        ebp = next_pcb -> stack_switch_bp;
-
-        tss.esp0 = MB_8 - (active_process * KB_8) - 4;  // 4 for a line of 32bits
-        tss.ss0 = KERNEL_DS;
-        asm volatile("              \n\
-                movl    %0, %%ebp   \n\
-                movl    %1, %%esp   \n\
-                leave               \n\
-                ret                 \n\
-                "
-            :
-            : "r"(ebp), "r"(esp)
-            : "memory"
-        );
-        return;
+    switch_process_cursor(sched_last ? sched_last -> terminal : next -> terminal, next -> terminal);
+    sched_last = next;
+    switch_account(cur, start);
+    // registers, esp0, page directory and stack
+    switch_to(cur ? &cur -> stack_switch_p : NULL, next -> stack_switch_p,
+              get_kernel_stack(next -> current_id), process_page_directory[next -> current_id]);
+}
+
+/* sched_set_priority
+ *
+ * Change the priority of a process, moving it in the run queue if it waits
+ * there
+ * Inputs: pcb -- the process
+ *         priority -- below SCHED_PRIO_NUM
+ * Outputs: None
+ * Side Effects: change the run queue
+ */
+void sched_set_priority(pcb_t* pcb, uint32_t priority){
+    uint32_t flags;
+    cli_and_save(flags);
+    pcb -> priority = priority;
+    if (pcb -> state == TASK_RUNNABLE && pcb != sched_cur) {
+        sched_dequeue(pcb);
+        run_enqueue(pcb);
+    }
+    restore_flags(flags);
+}
+
+/* sched_preempt
+ *
+ * Switch right away if a process more important than the running one was
+ * woken, called at the end of interrupt handlers that wake readers
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: may switch process
+ */
+void sched_preempt(void){
+    uint32_t flags;
+    pcb_t* next;
+    cli_and_save(flags);
+    next = run_first();
+    if (sched_cur && next &&
+        (sched_cur == &idle_pcb || sched_prio(next) < sched_prio(sched_cur)))
+        schedule();
+    restore_flags(flags);
+}
+
+/* sched_yield
+ *
+ * Let the other runnable processes run before the current one continues,
+ * used by busy waits in the drivers
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: may switch process
+ */
+void sched_yield(void){
+    uint32_t flags;
+    cli_and_save(flags);
+    schedule();
+    restore_flags(flags);
+}
+
+/* sched_current
+ *
+ * Inputs: None
+ * Outputs: the running process, NULL before the first one runs and while
+ *          the idle task runs
+ * Side Effects: None
+ */
+pcb_t* sched_current(void){
+    return sched_cur == &idle_pcb ? NULL : sched_cur;
+}
+
+/* sched_prepare_frame
+ *
+ * Make the first switch to a process return through syscall_ret, so it
+ * enters user mode with the frame at the top of its kernel stack. Below the
+ * frame go the return address and the four registers switch_to pops.
+ * Inputs: pcb -- the process, with its user frame already in place
+ * Outputs: None
+ * Side Effects: write its kernel stack, set stack_switch_p
+ */
+void sched_prepare_frame(pcb_t* pcb){
+    uint32_t* frame = (uint32_t*)(get_kernel_stack(pcb -> current_id) - SYSCALL_FRAME_SIZE);
+    frame[-1] = (uint32_t)syscall_ret;
+    memset(&frame[-1 - SWITCH_SAVED_REGS], 0, SWITCH_SAVED_REGS * sizeof(uint32_t));
+    pcb -> stack_switch_p = (uint32_t)&frame[-1 - SWITCH_SAVED_REGS];
+}
+
+/* sched_prepare_user
+ *
+ * Build the frame that starts a freshly loaded program at its entry point
+ * Inputs: pcb -- the process
+ *         eip -- entry point of the program
+ * Outputs: None
+ * Side Effects: write its kernel stack
+ */
+void sched_prepare_user(pcb_t* pcb, uint32_t eip){
+    uint32_t* frame = (uint32_t*)(get_kernel_stack(pcb -> current_id) - SYSCALL_FRAME_SIZE);
+    memset(frame, 0, SYSCALL_FRAME_SIZE);
+    frame[SYSCALL_FRAME_DS] = USER_DS;
+    frame[SYSCALL_FRAME_DS + 1] = USER_DS;     // es
+    frame[SYSCALL_FRAME_DS + 2] = USER_DS;     // fs
+    frame[SYSCALL_FRAME_EIP] = eip;
+    frame[SYSCALL_FRAME_EIP + 1] = USER_CS;
+    frame[SYSCALL_FRAME_EIP + 2] = USER_EFLAGS;
+    frame[SYSCALL_FRAME_EIP + 3] = USER_STACK_TOP;
+    frame[SYSCALL_FRAME_EIP + 4] = USER_DS;    // ss
+    sched_prepare_frame(pcb);
+}
+
+/* sched_show
+ *
+ * Fill the sched pseudo file: time spent idle, the time slice, the cost of
+ * a tick and of a context switch, then cpu share, switches and waiting
+ * time of every process
+ * Inputs: out -- text of the file
+ * Outputs: None
+ * Side Effects: None
+ */
+static void sched_show(pseudo_buf_t* out){
+    uint32_t pid, life;
+    pcb_t* pcb;
+    // totals first, the process table may not fit in the file
+    // whatever the idle task did not get was used by processes
+    life = pit_cnt - idle_pcb.start_tick;
+    pseudo_puts(out, "idle ticks: ");
+    pseudo_putu(out, idle_pcb.run_ticks, 0);
+    pseudo_puts(out, ", cpu busy%: ");
+    pseudo_putu(out, life ? 100 - idle_pcb.run_ticks * 100 / life : 0, 0);
+    pseudo_puts(out, "\n");
+    pseudo_puts(out, "quantum: ");
+    pseudo_putu(out, sched_quantum, 0);
+    pseudo_puts(out, " ticks\n");
+    pseudo_puts(out, "timer interrupts: ");
+    pseudo_putu(out, pit_irq_cnt, 0);
+    pseudo_puts(out, pit_mode == PIT_PERIODIC ? ", periodic" : ", one-shot");
+    pseudo_puts(out, ", cycles/tick: ");
+    pseudo_putu(out, pit_irq_cnt ? tick_cycles / pit_irq_cnt : 0, 0);
+    pseudo_puts(out, "\n");
+    pseudo_puts(out, "switches: ");
+    pseudo_putu(out, switch_cnt, 0);
+    pseudo_puts(out, ", cycles/switch: ");
+    pseudo_putu(out, switch_cnt ? switch_cycles / switch_cnt : 0, 0);
+    pseudo_puts(out, "\n");
+    pseudo_puts(out, "  pid      ter     prio    state    ticks   share%     runs      vol    invol  wait kcyc     last\n");
+    for (pid = 0; pid < MAX_PROCESS; pid++) {
+        pcb = pcb_table[pid];
+        if (!pcb || pcb -> state == TASK_DEAD) continue;
+        life = pit_cnt - pcb -> start_tick;
+        pseudo_putu(out, pid, SCHED_COL_NUM - 4);
+        pseudo_putu(out, pcb -> terminal, SCHED_COL_NUM);
+        pseudo_putu(out, sched_prio(pcb), SCHED_COL_NUM);
+        pseudo_puts(out, pcb -> state == TASK_RUNNABLE ? "      run" : "    block");
+        pseudo_putu(out, pcb -> run_ticks, SCHED_COL_NUM);
+        pseudo_putu(out, life ? pcb -> run_ticks * 100 / life : 0, SCHED_COL_NUM);
+        pseudo_putu(out, pcb -> run_cnt, SCHED_COL_NUM);
+        pseudo_putu(out, pcb -> nvcsw, SCHED_COL_NUM);
+        pseudo_putu(out, pcb -> nivcsw, SCHED_COL_NUM);
+        pseudo_putu(out, pcb -> run_cnt ? pcb -> wait_cycles / pcb -> run_cnt / 1000 : 0, SCHED_COL_NUM + 2);
+        pseudo_putu(out, pcb -> last_tick, SCHED_COL_NUM);
+        pseudo_puts(out, "\n");
+    }
+}
+
+/* sched_store
+ *
+ * Set the time slice from a number of pit ticks written to the sched file
+ * Inputs: buf -- the text, a number optionally followed by a line end
+ *         nbytes -- its length
+ * Outputs: Return nbytes on success
+ *          Return -1 if it is not a number from 1 to SCHED_QUANTUM_MAX
+ * Side Effects: Change the quantum from the next slice on
+ */
+static int32_t sched_store(const int8_t* buf, int32_t nbytes){
+    uint32_t quantum = 0;
+    int32_t i;
+    for (i = 0; i < nbytes && buf[i] >= '0' && buf[i] <= '9'; i++) {
+        quantum = quantum * 10 + buf[i] - '0';
+        if (quantum > SCHED_QUANTUM_MAX) return -1;
     }
+    if (quantum == 0) return -1;
+    if (i < nbytes && buf[i] != '\n' && buf[i] != '\0') return -1;
+    sched_quantum = quantum;
+    return nbytes;
 }
@@ -1,4 +1,8 @@
+#ifndef _SCHEDULER_H
+#define _SCHEDULER_H
+
 #include "types.h"
+#include "x86_desc.h"
 
 // PIT init consts
 #define PIT_PORT    0x43
@@ -6,12 +10,60 @@
 
 #define PIT_IRQ     0
 #define PIT_CMD     0x34    // Channel 0, Mode 2
+#define PIT_ONESHOT_CMD 0x30    // Channel 0, Mode 0, interrupt on terminal count
+#define PIT_LATCH_CMD   0x00    // Channel 0, latch the count
 #define HIFREQ      0x2E
 #define LOFREQ      0x9B
+#define PIT_RELOAD  ((HIFREQ << 8) | LOFREQ)    // input clocks per tick
+#define PIT_IDLE_TICKS  5       // longest one-shot the 16 bit counter allows
+#define BYTE_MASK   0xFF
+
+// PIT channel 0 modes
+#define PIT_PERIODIC    0       // a tick every PIT_RELOAD clocks
+#define PIT_ONESHOT     1       // one interrupt after pit_oneshot_count clocks
+#define PIT_STOPPED     2       // the one-shot fired, nothing armed
+
+// process states
+#define TASK_DEAD       0
+#define TASK_RUNNABLE   1
+#define TASK_BLOCKED    2
+
+// priorities, a lower number runs first
+#define SCHED_PRIO_NUM      4
+#define SCHED_PRIO_DEFAULT  2
+
+// time slice in pit ticks, set by writing the number to the sched file
+#define SCHED_QUANTUM_DEFAULT   1
+#define SCHED_QUANTUM_MAX       100
+
+#define USER_EFLAGS     0x202   // IF set, bit 1 reserved
+#define SCHED_COL_NUM   9       // width of a number column in the sched file
+#define SWITCH_SAVED_REGS 4     // ebp, ebx, esi and edi, pushed by switch_to
+
+// pit interrupt counter
+extern uint32_t pit_cnt;
 
 // PIT functions
 void pit_init();
 void pit_handler();
 
-// Switch process to the scheduled terminal
-void switch_process(unsigned int next_ter);
+// Run queue
+void sched_wake(pcb_t* pcb);
+void sched_run_next(pcb_t* pcb);
+void sched_dequeue(pcb_t* pcb);
+void sched_preempt(void);
+void sched_set_priority(pcb_t* pcb, uint32_t priority);
+
+// Give the cpu to the next runnable process
+void schedule(void);
+void sched_yield(void);
+pcb_t* sched_current(void);
+
+// Save the current process and resume the next one
+extern void switch_to(uint32_t* prev_sp, uint32_t next_sp, uint32_t next_esp0, void* next_dir);
+
+// Build the kernel stack a new process is first switched to
+void sched_prepare_user(pcb_t* pcb, uint32_t eip);
+void sched_prepare_frame(pcb_t* pcb);
+
+#endif /* _SCHEDULER_H */
@@ -45,7 +45,11 @@ void signal_deliver(){
   cli();
   cur_pcb->pending.lock = 1;
   // Check if there's any pending signals
-  if (cur_pcb->pending.head == cur_pcb->pending.tail) return;
+  if (cur_pcb->pending.head == cur_pcb->pending.tail) {
+    cur_pcb->pending.lock = 0;
+    sti();
+    return;
+  }
   // Get the top signal from the queue
   int32_t signum = cur_pcb->pending.pending_signums[(int)cur_pcb->pending.head];
   // Update head
@@ -0,0 +1,224 @@
+/* slab.c - Functions for the kernel object allocator. Each cache hands out
+ * objects of one size from slabs, single frames taken from frame_alloc.
+ * kmalloc picks the power of two size class that fits.
+ */
+
+#include "slab.h"
+#include "frame_alloc.h"
+#include "pseudo_fs.h"
+#include "lib.h"
+
+#define SLAB_HDR_SIZE   ((sizeof(slab_t) + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1))
+#define SLAB_COL_NAME   16      // slabinfo column widths
+#define SLAB_COL_NUM    9
+
+static kmem_cache_t kmem_caches[KMEM_CACHE_NUM];
+static uint32_t kmem_cache_cnt = 0;
+
+/* slab_unlink
+ *
+ * Remove a slab from one of its cache's lists
+ * Inputs: list -- head of the list
+ *         slab -- the slab, must be on the list
+ * Outputs: None
+ * Side Effects: Change the list
+ */
+static void slab_unlink(slab_t** list, slab_t* slab){
+    while (*list && *list != slab) list = &(*list)->next;
+    if (*list) *list = slab->next;
+    slab->next = NULL;
+}
+
+/* slab_new
+ *
+ * Get a frame and cut it into free objects
+ * Inputs: cache -- cache the slab is for
+ * Outputs: the new slab, NULL if memory is exhausted
+ * Side Effects: Take a frame
+ */
+static slab_t* slab_new(kmem_cache_t* cache){
+    uint32_t i;
+    uint8_t* obj;
+    slab_t* slab = (slab_t*)frame_alloc();
+    if (!slab) return NULL;
+    slab->next = NULL;
+    slab->cache = cache;
+    slab->inuse = 0;
+    slab->free = NULL;
+    // link the objects back to front so they are handed out in address order
+    obj = (uint8_t*)slab + SLAB_HDR_SIZE + (cache->per_slab - 1) * cache->obj_size;
+    for (i = 0; i < cache->per_slab; i++, obj -= cache->obj_size) {
+        *(void**)obj = slab->free;
+        slab->free = obj;
+    }
+    cache->slab_cnt++;
+    return slab;
+}
+
+/* kmem_cache_create
+ *
+ * Make a cache for objects of one size
+ * Inputs: name -- shown in slabinfo
+ *         size -- object size in bytes, at most KMALLOC_MAX
+ * Outputs: the cache, NULL if the size is too big or no cache is left
+ * Side Effects: None, slabs are taken on the first allocation
+ */
+kmem_cache_t* kmem_cache_create(const int8_t* name, uint32_t size){
+    kmem_cache_t* cache;
+    if (!size || size > KMALLOC_MAX || kmem_cache_cnt >= KMEM_CACHE_NUM) return NULL;
+    cache = &kmem_caches[kmem_cache_cnt++];
+    memset(cache, 0, sizeof(kmem_cache_t));
+    strncpy(cache->name, name, KMEM_NAME_LEN - 1);
+    cache->obj_size = (size + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1);
+    cache->per_slab = (SLAB_SIZE - SLAB_HDR_SIZE) / cache->obj_size;
+    return cache;
+}
+
+/* kmem_cache_alloc
+ *
+ * Take an object from a cache, from a partly used slab when there is one
+ * Inputs: cache -- the cache
+ * Outputs: the object, NULL if memory is exhausted
+ * Side Effects: May take a frame
+ */
+void* kmem_cache_alloc(kmem_cache_t* cache){
+    uint32_t flags;
+    slab_t* slab;
+    void* obj;
+    cli_and_save(flags);
+    slab = cache->partial;
+    if (!slab) {
+        slab = cache->empty ? cache->empty : slab_new(cache);
+        cache->empty = NULL;
+        if (!slab) {
+            cache->fail_cnt++;
+            restore_flags(flags);
+            return NULL;
+        }
+        slab->next = NULL;
+        cache->partial = slab;
+    }
+    obj = slab->free;
+    slab->free = *(void**)obj;
+    slab->inuse++;
+    if (!slab->free) {
+        cache->partial = slab->next;
+        slab->next = cache->full;
+        cache->full = slab;
+    }
+    cache->alloc_cnt++;
+    cache->active++;
+    restore_flags(flags);
+    return obj;
+}
+
+/* kmem_cache_free
+ *
+ * Give an object back to its cache. A slab that becomes empty is kept if
+ * the cache has no spare one, otherwise its frame is freed.
+ * Inputs: cache -- the cache the object came from
+ *         obj -- the object, may be NULL
+ * Outputs: None
+ * Side Effects: May free a frame
+ */
+void kmem_cache_free(kmem_cache_t* cache, void* obj){
+    uint32_t flags;
+    slab_t* slab;
+    if (!obj) return;
+    slab = (slab_t*)((uint32_t)obj & ~(SLAB_SIZE - 1));
+    cli_and_save(flags);
+    if (!slab->free) {
+        slab_unlink(&cache->full, slab);
+        slab->next = cache->partial;
+        cache->partial = slab;
+    }
+    *(void**)obj = slab->free;
+    slab->free = obj;
+    slab->inuse--;
+    if (!slab->inuse) {
+        slab_unlink(&cache->partial, slab);
+        if (!cache->empty) {
+            cache->empty = slab;
+        } else {
+            frame_free((uint32_t)slab);
+            cache->slab_cnt--;
+        }
+    }
+    cache->free_cnt++;
+    cache->active--;
+    restore_flags(flags);
+}
+
+/* kmalloc
+ *
+ * Allocate from the smallest size class that fits
+ * Inputs: size -- bytes needed, at most KMALLOC_MAX
+ * Outputs: the memory, NULL if the size is 0, too big, or memory is exhausted
+ * Side Effects: May take a frame
+ */
+void* kmalloc(uint32_t size){
+    uint32_t i;
+    if (!size || size > KMALLOC_MAX) return NULL;
+    for (i = 0; (1U << (KMALLOC_MIN_SHIFT + i)) < size; i++);
+    return kmem_cache_alloc(&kmem_caches[i]);
+}
+
+/* kfree
+ *
+ * Free memory from kmalloc or any cache, the slab header finds the cache
+ * Inputs: obj -- the memory, may be NULL
+ * Outputs: None
+ * Side Effects: May free a frame
+ */
+void kfree(void* obj){
+    if (!obj) return;
+    kmem_cache_free(((slab_t*)((uint32_t)obj & ~(SLAB_SIZE - 1)))->cache, obj);
+}
+
+/* slabinfo_show
+ *
+ * Fill the slabinfo pseudo file with the counters of every cache
+ * Inputs: out -- text being built
+ * Outputs: None
+ * Side Effects: None
+ */
+static void slabinfo_show(pseudo_buf_t* out){
+    uint32_t i;
+    int32_t pad;
+    kmem_cache_t* cache;
+    pseudo_puts(out, "cache             size   active    slabs   allocs    frees    fails\n");
+    for (i = 0; i < kmem_cache_cnt; i++) {
+        cache = &kmem_caches[i];
+        pseudo_puts(out, cache->name);
+        for (pad = SLAB_COL_NAME - (int32_t)strlen(cache->name); pad > 0; pad--) pseudo_puts(out, " ");
+        pseudo_putu(out, cache->obj_size, SLAB_COL_NUM - 3);
+        pseudo_putu(out, cache->active, SLAB_COL_NUM);
+        pseudo_putu(out, cache->slab_cnt, SLAB_COL_NUM);
+        pseudo_putu(out, cache->alloc_cnt, SLAB_COL_NUM);
+        pseudo_putu(out, cache->free_cnt, SLAB_COL_NUM);
+        pseudo_putu(out, cache->fail_cnt, SLAB_COL_NUM);
+        pseudo_puts(out, "\n");
+    }
+    pseudo_puts(out, "free frames: ");
+    pseudo_putu(out, frame_free_count(), 0);
+    pseudo_puts(out, "\n");
+}
+
+/* slab_init
+ *
+ * Create the kmalloc size classes, size-16 to size-2048, and the slabinfo
+ * pseudo file
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: Initialize kmem_caches
+ */
+void slab_init(void){
+    uint32_t i;
+    int8_t name[KMEM_NAME_LEN] = "size-";
+    kmem_cache_cnt = 0;
+    for (i = 0; i < KMALLOC_CLASSES; i++) {
+        itoa(1 << (KMALLOC_MIN_SHIFT + i), name + strlen("size-"), 10);
+        (void)kmem_cache_create(name, 1 << (KMALLOC_MIN_SHIFT + i));
+    }
+    (void)pseudo_register("slabinfo", slabinfo_show, NULL);
+}
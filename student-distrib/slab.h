@@ -0,0 +1,53 @@
+/* slab.h - Defines used for the kernel object allocator
+ */
+
+#ifndef _SLAB_H
+#define _SLAB_H
+
+#include "types.h"
+
+#define SLAB_SIZE           0x1000      // one frame per slab
+#define SLAB_ALIGN          8           // object alignment, also the smallest object
+#define KMALLOC_MIN_SHIFT   4           // smallest kmalloc size class, 16 bytes
+#define KMALLOC_CLASSES     8           // 16 .. 2048 bytes
+#define KMALLOC_MAX         (1 << (KMALLOC_MIN_SHIFT + KMALLOC_CLASSES - 1))
+#define KMEM_CACHE_NUM      24          // size classes and named caches
+#define KMEM_NAME_LEN       16
+
+// A slab: one frame, this header at its start, then objects
+typedef struct slab {
+    struct slab* next;
+    struct kmem_cache* cache;
+    void* free;                 // singly linked list through the free objects
+    uint32_t inuse;
+} slab_t;
+
+// Objects of one size, carved out of slabs
+typedef struct kmem_cache {
+    int8_t name[KMEM_NAME_LEN];
+    uint32_t obj_size;
+    uint32_t per_slab;
+    slab_t* partial;            // slabs with free objects
+    slab_t* full;
+    slab_t* empty;              // at most one free slab kept to avoid churn
+    // counters shown in the slabinfo pseudo file
+    uint32_t alloc_cnt;
+    uint32_t free_cnt;
+    uint32_t fail_cnt;
+    uint32_t active;
+    uint32_t slab_cnt;
+} kmem_cache_t;
+
+// Set up the size classes and the slabinfo pseudo file
+void slab_init(void);
+
+// Named caches for fixed size kernel objects
+kmem_cache_t* kmem_cache_create(const int8_t* name, uint32_t size);
+void* kmem_cache_alloc(kmem_cache_t* cache);
+void kmem_cache_free(kmem_cache_t* cache, void* obj);
+
+// General purpose allocation up to KMALLOC_MAX bytes
+void* kmalloc(uint32_t size);
+void kfree(void* obj);
+
+#endif /* _SLAB_H */
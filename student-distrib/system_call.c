@@ -4,59 +4,85 @@
 #include "task.h"
 #include "paging_init.h"
 #include "rtc.h"
+#include "loader.h"
+#include "pseudo_fs.h"
+#include "scheduler.h"
+#include "wait_queue.h"
+#include "pipe.h"
 
 #include "signal.h"
 
+// stack SYSENTER loads, the entry moves to the process's esp0 right away
+static uint32_t sysenter_stack[SYSENTER_STACK_WORDS];
+
+/* sysenter_init
+ *
+ * Point the SYSENTER MSRs at sysenter_entry if the cpu has SYSENTER.
+ * User programs check CPUID themselves and use int $0x80 otherwise.
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: write the MSRs
+ */
+void sysenter_init(void){
+    if (!(cpuid_edx(CPUID_FEATURES) & CPUID_SEP)) return;
+    wrmsr(MSR_SYSENTER_CS, KERNEL_CS, 0);
+    wrmsr(MSR_SYSENTER_ESP, (uint32_t)&sysenter_stack[SYSENTER_STACK_WORDS], 0);
+    wrmsr(MSR_SYSENTER_EIP, (uint32_t)sysenter_entry, 0);
+}
+
+/* process_exit
+ *
+ * Tear down a process and hand its status to its parent if the parent is
+ * waiting for it in execute
+ * Inputs: pcb -- the process, the current one or one that is not running
+ *         status -- return value for the parent
+ * Outputs: None, does not return if pcb is the current process
+ * Side Effects: free the process, give the terminal back to the parent,
+ *               wake the parent, switch process
+ */
+static void process_exit(pcb_t* pcb, int32_t status){
+    uint8_t pid = pcb -> current_id;
+    pcb_t* par_pcb = (pcb_t*)pcb->parent_pointer;
+    sched_dequeue(pcb);
+    wait_queue_remove(pcb);
+    pcb -> state = TASK_DEAD;
+    // free the user pages
+    task_halt(pid);
+    // close all the fds
+    close_fds(pcb);
+    if (terminal_pid[pcb -> terminal] == pid) terminal_pid[pcb -> terminal] = pcb -> parent_id;
+    if (par_pcb && par_pcb -> state == TASK_BLOCKED && par_pcb -> wait_pid == pid) {
+        par_pcb -> child_status = status;
+        sched_wake(par_pcb);
+    }
+    // a dead process is never queued again, its kernel stack is kept for the pid
+    if (pcb == sched_current()) schedule();
+}
+
 /* int32_t sys_halt(uin8_t status);
  * Inputs: status -- return value for current process
- * Return Value: 0
- * Function: restore parent process, close files and return to parent process */
+ * Return Value: 0, -1 if a root shell halts and "shell" cannot be run
+ * Function: close files, free the process and wake its parent */
 int32_t sys_halt(uint8_t status) {
     cli();
     pcb_t* cur_pcb = get_pcb();
-    uint8_t cur_pid = cur_pcb -> current_id;
     // if it is the last shell process, we just restart it
     if(cur_pcb->parent_pointer == 0){
         clear_terminal();
         printf("Restarting the shell...\n");
-        int32_t eip = extract_ip((uint8_t*)"shell");
-        iret_handler(eip);
+        exec_info_t shell_info;
+        if (exec_prepare((uint8_t*)"shell", &shell_info)) return -1;
+        iret_handler(shell_info.entry);
     }
-    uint8_t par_pid = cur_pcb -> parent_id;
-    pcb_t* par_pcb = (pcb_t*)cur_pcb->parent_pointer;
-    // restore parent paging
-    task_halt(cur_pid);
-    // close all the fds
-    close_fds();
-    active_process = par_pid;
-    uint8_t par_ter = par_pcb -> terminal;
-    terminal_pid[par_ter] = par_pid;
-    int32_t ret_val = (int32_t) status;
-    // restore parent data
-    uint32_t esp = par_pcb -> stack_p;
-    uint32_t ebp = par_pcb -> stack_bp;
-    tss.esp0 = MB_8 - (par_pid * KB_8) - 4;
-    tss.ss0 = KERNEL_DS;
-    // jump to execute return
-    asm volatile("              \n\
-            movl    %0, %%eax   \n\
-            movl    %1, %%ebp   \n\
-            movl    %2, %%esp   \n\
-            leave               \n\
-            ret                 \n\
-            "
-        :
-        : "r"(ret_val),"r"(ebp), "r"(esp)
-        : "memory"
-    );
+    process_exit(cur_pcb, (int32_t)status);
     return 0;
 }
 
 /* int32_t sys_execute(const uint8_t* command)
  * Inputs: command -- input command
- * Return Value: Return 0;
- * Function: Initialize a new process, load the program to memory, switch to its stack.
- *           Pass real return value through EAX.
+ * Return Value: Return the status the program halts with
+ * Function: Initialize a new process, load the program to memory, and let it
+ *           run in place of the caller, which blocks until it halts.
  */
 int32_t sys_exeute(const uint8_t* command){
     cli();
@@ -87,46 +113,43 @@ int32_t sys_exeute(const uint8_t* command){
         k++;
     }
     int32_t arg_len = strlen((int8_t*)arguments);
-    // Check if file is executable
-    if (check_executable(fname)) return -1;
+    // Check if file is executable and read its header once
+    exec_info_t info;
+    if (exec_prepare(fname, &info)) return -1;
     // set up program paging
     uint8_t new_pid = task_init();
     if(new_pid==(uint8_t)-1){  // if the task init returned -1
-        printf("no more than 6 process\n");
+        printf("no more process can be created\n");
         return 2;
     }
-    // load program to user stack
-    load_executable(fname);
     // initiate pcb
     pcb_t* new_pcb = init_pcb(new_pid,parent_pcb);
+    new_pcb->exec = info;
+    new_pcb->text = exec_share_get(&info);
+    // load program to user stack
+    exec_load(&info, new_pcb->text, new_pid);
     // printf("execute: %d, %d\n", new_pid, parent_pcb -> current_id);
-    new_pcb->terminal = active_ter;
-    // change termianl related
-    terminal_pid[active_ter] = new_pid;
-    // printf("active_ter: %d\n", active_ter);
-    active_process =new_pid;
+    new_pcb->terminal = parent_pcb->terminal;
+    // stdin and stdout carry over, so a shell can point them at a pipe
+    for (i = 0; i < 2; i++) {
+        new_pcb->fd_array[i] = parent_pcb->fd_array[i];
+        pipe_get(&new_pcb->fd_array[i]);
+    }
+    // change termianl related, a forked process running beside the
+    // foreground job (the left side of a pipe) must not take it over
+    if (terminal_pid[new_pcb->terminal] == parent_pcb->current_id)
+        terminal_pid[new_pcb->terminal] = new_pid;
     // copy arguments
     strncpy((int8_t*)(new_pcb -> argument), (int8_t*)arguments, arg_len);
-    // set esp0 and ss0
-    tss.esp0 = MB_8 - (new_pid * KB_8) - 4;   //should be 4 byte above
-    tss.ss0 = KERNEL_DS;
-    // return from kernel mode to user mode
-    int32_t eip = extract_ip(fname);
-    // get current esp and ebp, save to pcb
-    uint32_t esp,ebp;
-    asm volatile("                      \n\
-            movl %%ebp,%0               \n\
-            movl %%esp,%1               \n\
-        "
-        : "=r"(ebp), "=r"(esp)
-        :
-        : "memory"
-    );
-    parent_pcb->stack_bp=ebp;
-    parent_pcb->stack_p=esp;
-    // context switch
-    iret_handler(eip);
-    return 0;
+    // the child enters user mode at the entry point on its first switch
+    sched_prepare_user(new_pcb, info.entry);
+    // wait in the parent until the child halts
+    parent_pcb->wait_pid = new_pid;
+    parent_pcb->state = TASK_BLOCKED;
+    sched_run_next(new_pcb);
+    schedule();
+    parent_pcb->wait_pid = -1;
+    return parent_pcb->child_status;
 }
 
 /* int32_t sys_read(int32_t fd, void* buf, int32_t nbytes)
@@ -138,12 +161,13 @@ int32_t sys_exeute(const uint8_t* command){
  * Side Effects: Call on the real read funtion cooresponding to file_type.
  */
 int32_t sys_read(int32_t fd, void* buf, int32_t nbytes){
-    if (fd == 1) return -1;
     if (fd < 0 || fd >= MAX_FILE) return -1;
     cli();
     fd_t* fda = get_fa();
     sti();
     if (!fda[fd].flag) return -1;
+    // stdout cannot be read, wherever dup2 put it
+    if (!fda[fd].file_op_table_ptr -> read) return -1;
     return fda[fd].file_op_table_ptr -> read(fd, buf, nbytes);
 }
 
@@ -153,19 +177,103 @@ int32_t sys_read(int32_t fd, void* buf, int32_t nbytes){
  *         nbytes -- the number of bytes the data suppose to write
  * Outputs: Return whatever type specific wirte function returns
  *          Return -1 for invalid fd
- * Side Effects: Call on the real write funtion cooresponding to file_type.
+ * Side Effects: Call on the real write funtion cooresponding to file_type,
+ *               with interrupts off except for pipes.
  */
 int32_t sys_write(int32_t fd, const void* buf,int32_t nbytes){
-    if (fd == 0) return -1;
     if (fd < 0 || fd >= MAX_FILE) return -1;
     cli();
     fd_t* fda = get_fa();
-    if (!fda[fd].flag) return -1;
+    if (!fda[fd].flag || !fda[fd].file_op_table_ptr -> write) {
+        sti();
+        return -1;
+    }
+    // pipes copy with interrupts on and only turn them off to sleep
+    if (fda[fd].pipe) {
+        sti();
+        return fda[fd].file_op_table_ptr -> write(fd, buf, nbytes);
+    }
     int32_t ret = fda[fd].file_op_table_ptr -> write(fd, buf, nbytes);
     sti();
     return ret;
 }
 
+/* int32_t iov_check(const iovec_t* iov, int32_t iovcnt)
+ * Inputs: iov -- the buffers of a readv or writev
+ *         iovcnt -- how many there are
+ * Outputs: Return 0 if the array and every buffer lie in the user page
+ *          Return -1 otherwise, or for a negative length or count
+ * Side Effects: None
+ */
+static int32_t iov_check(const iovec_t* iov, int32_t iovcnt){
+    int32_t i;
+    if (iovcnt < 0 || iovcnt > IOV_MAX) return -1;
+    if ((uint32_t)iov < USER_PG_START || (uint32_t)iov > USER_PG_END - iovcnt * sizeof(iovec_t)) return -1;
+    for (i = 0; i < iovcnt; i++) {
+        if (iov[i].len < 0) return -1;
+        if ((uint32_t)iov[i].base < USER_PG_START || (uint32_t)iov[i].len > USER_PG_END - (uint32_t)iov[i].base) return -1;
+    }
+    return 0;
+}
+
+/* int32_t sys_readv(int32_t fd, const iovec_t* iov, int32_t iovcnt)
+ * Inputs: fd -- file descriptor number
+ *         iov -- the buffers, filled in order
+ *         iovcnt -- how many there are, at most IOV_MAX
+ * Outputs: Return the total number of bytes read
+ *          Return -1 for invalid fd or arguments, a buffer outside the user
+ *          page, or if the first read fails
+ * Side Effects: Call the read function of the file once per buffer, and
+ *               stop after a short read.
+ */
+int32_t sys_readv(int32_t fd, const iovec_t* iov, int32_t iovcnt){
+    int32_t i, cnt, total = 0;
+    if (fd < 0 || fd >= MAX_FILE) return -1;
+    if (iov_check(iov, iovcnt)) return -1;
+    cli();
+    fd_t* fda = get_fa();
+    sti();
+    if (!fda[fd].flag || !fda[fd].file_op_table_ptr -> read) return -1;
+    for (i = 0; i < iovcnt; i++) {
+        cnt = fda[fd].file_op_table_ptr -> read(fd, iov[i].base, iov[i].len);
+        if (cnt < 0) return total ? total : -1;
+        total += cnt;
+        if (cnt < iov[i].len) break;
+    }
+    return total;
+}
+
+/* int32_t sys_writev(int32_t fd, const iovec_t* iov, int32_t iovcnt)
+ * Inputs: fd -- file descriptor number
+ *         iov -- the buffers, written in order
+ *         iovcnt -- how many there are, at most IOV_MAX
+ * Outputs: Return the total number of bytes written
+ *          Return -1 for invalid fd or arguments, a buffer outside the user
+ *          page, or if the first write fails
+ * Side Effects: Hand the whole vector to the file's writev if it has one,
+ *               otherwise call its write function once per buffer.
+ */
+int32_t sys_writev(int32_t fd, const iovec_t* iov, int32_t iovcnt){
+    int32_t i, cnt, total = 0;
+    file_op_table_t* ops;
+    if (fd < 0 || fd >= MAX_FILE) return -1;
+    if (iov_check(iov, iovcnt)) return -1;
+    cli();
+    fd_t* fda = get_fa();
+    sti();
+    if (!fda[fd].flag) return -1;
+    ops = fda[fd].file_op_table_ptr;
+    if (ops -> writev) return ops -> writev(fd, iov, iovcnt);
+    if (!ops -> write) return -1;
+    for (i = 0; i < iovcnt; i++) {
+        cnt = ops -> write(fd, iov[i].base, iov[i].len);
+        if (cnt < 0) return total ? total : -1;
+        total += cnt;
+        if (cnt < iov[i].len) break;
+    }
+    return total;
+}
+
 /* int32_t sys_open(const uint8_t* filename)
  * Inputs: filename -- File name
  * Outputs: Return whatever type specific open function returns
@@ -189,6 +297,7 @@ int32_t sys_open(const uint8_t* filename){
     fda[fdi].inode_idx = dentry.inode_num;
     fda[fdi].file_pos = 0;
     fda[fdi].flag = FILE_IN_USE;
+    fda[fdi].pipe = NULL;
     int32_t file_type = dentry.filetype;
     switch (file_type) {
     case FILE_TYPE:
@@ -199,7 +308,11 @@ int32_t sys_open(const uint8_t* filename){
         break;
     case RTC_TYPE:
         fda[fdi].file_op_table_ptr = &rtc_op_table;
-        fda[fdi].file_pos = RTC_FREQ_MAX / RTC_FREQ_MIN / TER_NUM;
+        fda[fdi].file_pos = RTC_FREQ_MAX / RTC_FREQ_MIN;
+        fda[fdi].inode_idx = tick_counter;
+        break;
+    case PSEUDO_TYPE:
+        fda[fdi].file_op_table_ptr = &pseudo_op_table;
         break;
     default:
         return -1;
@@ -215,13 +328,15 @@ int32_t sys_open(const uint8_t* filename){
  * Outputs: Return -1 for fail to close
  *          Return 0 for success
  * Side Effects: Call on the real close funtion cooresponding to file_type.
- *               Mark the fd as not in use.
+ *               Mark the fd as not in use. A copy of stdin or stdout made
+ *               by dup2 has no close function and is only freed.
  */
 int32_t sys_close(int32_t fd){
     if (fd <= 1|| fd >= MAX_FILE) return -1;
     fd_t* fda = get_fa();
     if (!fda[fd].flag) return -1;
-    int32_t ret = fda[fd].file_op_table_ptr -> close(fd);
+    int32_t ret = 0;
+    if (fda[fd].file_op_table_ptr -> close) ret = fda[fd].file_op_table_ptr -> close(fd);
     if (ret) return ret;
     fda[fd].flag = FILE_NOT_IN_USE;
     return 0;
@@ -253,9 +368,12 @@ int32_t sys_getargs(uint8_t* buf,int32_t nbytes){
  */
 int32_t sys_vidmap(uint8_t** screen_start){
     if (!screen_start) return -1;
-    if (KERNEL_LOW <= (int32_t)screen_start && (int32_t)screen_start < KERNEL_HIGH) return -1;
-    page_directory[USER_VIDEO_V_OFF].present = 1;
+    // the pointer has to be in the user program page
+    if ((uint32_t)screen_start < USER_PG_START || (uint32_t)screen_start > USER_PG_END - sizeof(uint8_t*)) return -1;
+    pcb_t* cur_pcb = get_pcb();
+    process_page_directory[cur_pcb->current_id][USER_VIDEO_V_OFF].present = 1;
     user_video_page_table[VIDEO_START_OFF].present = 1;
+    invalidatePage(USER_VIDEO_V_ADDR);
     *screen_start = (uint8_t*)USER_VIDEO_V_ADDR;
     return 0;
 }
@@ -289,37 +407,198 @@ int32_t sys_sigreturn(void){
     return -1;
 }
 
-/* int32_t execute_shell();
+/* int32_t sys_fork(void)
  * Inputs: None
- * Return Value: Return 0
- * Function: Execute shell in kernel.c as the first user program.
+ * Return Value: Return the child pid in the parent, 0 in the child
+ *               Return -1 if no process can be created
+ * Function: Clone the calling process. The child gets a copy of the pcb and
+ *           fd table and shares the user pages copy-on-write. Both keep
+ *           running, the child is queued behind the other runnable processes.
  */
-int32_t execute_shell(uint32_t ter){
+int32_t sys_fork(void){
+    int i;
     cli();
-    if (ter == 0){
-        clear_terminal();
-        // initialize to -1 to indicate no process running
-        terminal_pid[0] = -1;
-        terminal_pid[1] = -1;
-        terminal_pid[2] = -1;
+    pcb_t* parent_pcb = get_pcb();
+    uint8_t parent_pid = parent_pcb -> current_id;
+    uint8_t child_pid = task_init();
+    if(child_pid==(uint8_t)-1){  // no pid or memory left
+        task_switch_pg(parent_pid);
+        return -1;
+    }
+    pcb_t* child_pcb = init_pcb(child_pid, parent_pcb);
+    memcpy(child_pcb -> fd_array, parent_pcb -> fd_array, sizeof(fd_t) * MAX_FILE);
+    for (i = 0; i < MAX_FILE; i++) pipe_get(&child_pcb -> fd_array[i]);
+    memcpy(child_pcb -> argument, parent_pcb -> argument, ARG_BUF_SIZE);
+    child_pcb -> terminal = parent_pcb -> terminal;
+    child_pcb -> exec = parent_pcb -> exec;
+    child_pcb -> text = exec_share_dup(parent_pcb -> text);
+    child_pcb -> ring = parent_pcb -> ring;
+    #ifdef TEST_EXTRA
+    child_pcb -> handler = parent_pcb -> handler;
+    #endif
+    task_fork_pg(parent_pid, child_pid);
+    // the child returns from the same int $0x80 as the parent, with eax 0
+    uint32_t* child_frame = (uint32_t*)(get_kernel_stack(child_pid) - SYSCALL_FRAME_SIZE);
+    memcpy(child_frame, (void*)(get_kernel_stack(parent_pid) - SYSCALL_FRAME_SIZE), SYSCALL_FRAME_SIZE);
+    child_frame[SYSCALL_FRAME_EAX] = 0;
+    sched_prepare_frame(child_pcb);
+    sched_wake(child_pcb);
+    // task_init left the child's directory loaded
+    task_switch_pg(parent_pid);
+    return child_pid;
+}
+
+/* int32_t sys_pipe(int32_t* fds)
+ * Inputs: fds -- takes the read end in fds[0] and the write end in fds[1]
+ * Return Value: Return 0 on success
+ *               Return -1 for a bad pointer, no free fds or no memory
+ * Function: Make a pipe and open an fd on each end. Reads sleep while it
+ *           is empty and return 0 once no writer is left; writes sleep
+ *           while it is full and fail once no reader is left.
+ */
+int32_t sys_pipe(int32_t* fds){
+    fd_t* fda = get_fa();
+    int32_t rfd, wfd;
+    if ((uint32_t)fds < USER_PG_START || (uint32_t)fds > USER_PG_END - 2 * sizeof(int32_t)) return -1;
+    for (rfd = 2; rfd < MAX_FILE && fda[rfd].flag; rfd++);
+    for (wfd = rfd + 1; wfd < MAX_FILE && fda[wfd].flag; wfd++);
+    if (wfd >= MAX_FILE) return -1;
+    if (pipe_create(&fda[rfd], &fda[wfd])) return -1;
+    fds[0] = rfd;
+    fds[1] = wfd;
+    return 0;
+}
+
+/* int32_t sys_dup2(int32_t oldfd, int32_t newfd)
+ * Inputs: oldfd -- an open fd
+ *         newfd -- the fd to make a copy of it, closed first if open
+ * Return Value: Return newfd on success, -1 for a bad fd
+ * Function: Make newfd refer to the same file as oldfd. Copying a pipe end
+ *           into fd 0 or 1 points stdin or stdout at the pipe, and
+ *           programs started with execute take them over.
+ */
+int32_t sys_dup2(int32_t oldfd, int32_t newfd){
+    fd_t* fda = get_fa();
+    if (oldfd < 0 || oldfd >= MAX_FILE || newfd < 0 || newfd >= MAX_FILE) return -1;
+    if (!fda[oldfd].flag) return -1;
+    if (oldfd == newfd) return newfd;
+    if (fda[newfd].flag) {
+        // stdin and stdout have no close function
+        if (fda[newfd].file_op_table_ptr -> close) fda[newfd].file_op_table_ptr -> close(newfd);
+        fda[newfd].flag = FILE_NOT_IN_USE;
+    }
+    fda[newfd] = fda[oldfd];
+    pipe_get(&fda[newfd]);
+    return newfd;
+}
+
+/* int32_t sys_poll(pollfd_t* fds, int32_t nfds, int32_t timeout)
+ * Inputs: fds -- the fds and the events each waits for
+ *         nfds -- how many there are, at most MAX_FILE
+ *         timeout -- milliseconds to wait, 0 to only check, -1 for ever
+ * Return Value: Return how many fds have revents set, 0 on timeout
+ *               Return -1 for invalid arguments or fds outside the user page
+ * Function: Sleep until one of the fds is ready. Each file's poll function
+ *           reports its events, and drivers wake pollers when one may
+ *           change, so a single loop can wait on the keyboard, the RTC and
+ *           pipes without spinning. The timeout counts RTC ticks.
+ */
+int32_t sys_poll(pollfd_t* fds, int32_t nfds, int32_t timeout){
+    fd_t* fda = get_fa();
+    file_op_table_t* ops;
+    uint32_t flags;
+    int32_t i, fd, events, ready, deadline = 0;
+    if (nfds < 0 || nfds > MAX_FILE) return -1;
+    // the whole array must be in the user page, nfds is small enough
+    // that the size cannot wrap
+    if ((uint32_t)fds < USER_PG_START || (uint32_t)fds > USER_PG_END - nfds * sizeof(pollfd_t)) return -1;
+    if (timeout > 0) {
+        if (timeout > POLL_TIMEOUT_MAX) timeout = POLL_TIMEOUT_MAX;
+        deadline = tick_counter + (timeout * RTC_FREQ_MAX + MS_PER_SEC - 1) / MS_PER_SEC;
+    }
+    // check and sleep with interrupts off so no wake up is missed
+    cli_and_save(flags);
+    while (1) {
+        ready = 0;
+        for (i = 0; i < nfds; i++) {
+            fd = fds[i].fd;
+            fds[i].revents = 0;
+            if (fd < 0) continue;
+            if (fd >= MAX_FILE || !fda[fd].flag) {
+                fds[i].revents = POLLNVAL;
+                ready++;
+                continue;
+            }
+            ops = fda[fd].file_op_table_ptr;
+            events = ops -> poll ? ops -> poll(fd) : POLLIN | POLLOUT;
+            fds[i].revents = events & (fds[i].events | POLLERR | POLLHUP);
+            if (fds[i].revents) ready++;
+        }
+        if (ready || !timeout) break;
+        if (timeout > 0) {
+            if (tick_counter >= deadline) break;
+            rtc_wake_at(deadline);
+        }
+        poll_sleep();
     }
+    restore_flags(flags);
+    return ready;
+}
+
+/* int32_t sys_setpriority(int32_t pid, int32_t priority)
+ * Inputs: pid -- process to change, -1 for the caller
+ *         priority -- 0 runs first, up to SCHED_PRIO_NUM - 1
+ * Return Value: Return 0 on success, -1 for a bad pid or priority
+ * Function: Set the priority a process is scheduled at. Children started
+ *           afterwards inherit it.
+ */
+int32_t sys_setpriority(int32_t pid, int32_t priority){
+    pcb_t* pcb;
+    if (priority < 0 || priority >= SCHED_PRIO_NUM) return -1;
+    if (pid == -1) {
+        pcb = get_pcb();
+    } else {
+        if (pid < 0 || pid >= MAX_PROCESS) return -1;
+        pcb = pcb_table[pid];
+        if (!pcb || pcb -> state == TASK_DEAD) return -1;
+    }
+    sched_set_priority(pcb, (uint32_t)priority);
+    // it may now outrank the caller
+    sched_preempt();
+    return 0;
+}
+
+/* int32_t execute_shell();
+ * Inputs: ter -- terminal the shell runs on
+ * Return Value: Return the pid of the shell, -1 if it cannot be created
+ * Function: Create the shell of a terminal and make it runnable.
+ */
+int32_t execute_shell(uint32_t ter){
+    cli();
     uint8_t* fname =(uint8_t*)"shell";
+    exec_info_t info;
+    if (exec_prepare(fname, &info)) {
+        printf("cannot run the shell\n");
+        return -1;
+    }
     // set up program paging
     uint8_t new_pid = task_init();
-    // load program to user stack
-    load_executable(fname);
+    if(new_pid==(uint8_t)-1){
+        printf("no memory for the shell\n");
+        return -1;
+    }
     // initiate pcb
     pcb_t* new_pcb = init_pcb(new_pid,0);
+    new_pcb->exec = info;
+    new_pcb->text = exec_share_get(&info);
+    // load program to user stack
+    exec_load(&info, new_pcb->text, new_pid);
     new_pcb->terminal=ter;
-    active_process = new_pid;
     terminal_pid[ter]=new_pid;
-    // set esp0 and ss0
-    tss.esp0 =  MB_8 - (new_pid * KB_8) - 4;   //should be 4 byte above
-    tss.ss0 = KERNEL_DS;
-    // return from kernel mode to user mode
-    int32_t eip = extract_ip(fname);
-    iret_handler(eip);
-    return 0;
+    // enter user mode at the entry point on its first switch
+    sched_prepare_user(new_pcb, info.entry);
+    sched_wake(new_pcb);
+    return new_pid;
 }
 
 /* int32_t sys_halt();
@@ -331,74 +610,25 @@ int32_t execute_shell(uint32_t ter){
 int32_t exception_halt(void) {
     cli();
     pcb_t* cur_pcb = get_pcb();
-    uint8_t cur_pid = cur_pcb -> current_id;
-    uint8_t par_pid = cur_pcb -> parent_id;
-    pcb_t* par_pcb = (pcb_t*)cur_pcb->parent_pointer;
-    active_process = par_pid;
-    uint8_t par_ter = par_pcb -> terminal;
-    terminal_pid[par_ter] = par_pid;
-    // restore parent paging
-    task_halt(cur_pid);
-    // close all the fds
-    close_fds();
-    int32_t ret_val = EXECPTION_RET;
-    // restore parent data
-    uint32_t esp = par_pcb -> stack_p;
-    uint32_t ebp = par_pcb -> stack_bp;
-    tss.esp0 = MB_8 - (par_pid * KB_8) - 4;
-    tss.ss0 = KERNEL_DS;
-    // jump to execute return
-    asm volatile("              \n\
-            movl    %0, %%eax   \n\
-            movl    %1, %%ebp   \n\
-            movl    %2, %%esp   \n\
-            leave               \n\
-            ret                 \n\
-            "
-        :
-        : "r"(ret_val),"r"(ebp), "r"(esp)
-        : "memory"
-    );
+    // a shell is restarted
+    if (cur_pcb->parent_pointer == 0) return sys_halt(0);
+    process_exit(cur_pcb, EXECPTION_RET);
     return 0;
 }
 
 /* int32_t sys_halt();
- * Inputs: None
- * Return Value: None
- * Function: Handle the halt causing by exeception,
- *           Functionning the same as sys_halt but always return 256 to execute
+ * Inputs: active_ter -- terminal on screen
+ * Return Value: Return -1 if there is no program to stop
+ * Function: Halt the program in the foreground of the terminal on Ctrl+C,
+ *           which need not be the running one. Its execute returns 256.
  */
 int32_t keyboard_halt(uint8_t active_ter) {
     cli();
     uint8_t halt_pid = terminal_pid[active_ter];
-    pcb_t* cur_pcb = get_pcb_by_id(halt_pid);
-    uint8_t cur_pid = cur_pcb -> current_id;
-    uint8_t par_pid = cur_pcb -> parent_id;
-    pcb_t* par_pcb = (pcb_t*)cur_pcb->parent_pointer;
-    active_process = par_pid;
-    uint8_t par_ter = par_pcb -> terminal;
-    terminal_pid[par_ter] = par_pid;
-    // restore parent paging
-    task_halt(cur_pid);
-    // close all the fds
-    close_fds();
-    int32_t ret_val = EXECPTION_RET;
-    // restore parent data
-    uint32_t esp = par_pcb -> stack_p;
-    uint32_t ebp = par_pcb -> stack_bp;
-    tss.esp0 = MB_8 - (par_pid * KB_8) - 4;
-    tss.ss0 = KERNEL_DS;
-    // jump to execute return
-    asm volatile("              \n\
-            movl    %0, %%eax   \n\
-            movl    %1, %%ebp   \n\
-            movl    %2, %%esp   \n\
-            leave               \n\
-            ret                 \n\
-            "
-        :
-        : "r"(ret_val),"r"(ebp), "r"(esp)
-        : "memory"
-    );
+    if (halt_pid == (uint8_t)-1) return -1;
+    pcb_t* halt_pcb = get_pcb_by_id(halt_pid);
+    // shells are not stopped
+    if (halt_pcb->parent_pointer == 0) return -1;
+    process_exit(halt_pcb, EXECPTION_RET);
     return 0;
 }
@@ -10,9 +10,23 @@
 
 #define EXECPTION_RET 256
 
-// Kernel Range
-#define KERNEL_LOW  0x400000
-#define KERNEL_HIGH 0x800000
+// Frame syscall_handler_asm leaves at the top of the kernel stack
+#define SYSCALL_FRAME_SIZE 64   // 10 saved registers, eax, and the iret frame
+#define SYSCALL_FRAME_EAX 6     // word holding the return value
+#define SYSCALL_FRAME_DS 7      // ds, es and fs follow
+#define SYSCALL_FRAME_EIP 11    // cs, eflags, esp and ss follow
+#define USER_STACK_TOP 0x83ffffc
+#define IOV_MAX 16              // most buffers a readv or writev takes
+#define MS_PER_SEC 1000
+#define POLL_TIMEOUT_MAX 0x1FFFFF // ms, about 35 minutes, keeps ticks in range
+
+// SYSENTER fast system calls
+#define CPUID_FEATURES 1        // leaf with the feature flags
+#define CPUID_SEP 0x800         // EDX bit 11: SYSENTER and SYSEXIT
+#define MSR_SYSENTER_CS 0x174   // kernel cs; SYSEXIT uses cs + 16 and cs + 24
+#define MSR_SYSENTER_ESP 0x175
+#define MSR_SYSENTER_EIP 0x176
+#define SYSENTER_STACK_WORDS 64 // only held until the entry switches to esp0
 
 // multi-terminal parameters
 uint8_t terminal_pid[TER_NUM];
@@ -30,6 +44,17 @@ int32_t sys_getargs(uint8_t* buf,int32_t nbytes);
 int32_t sys_vidmap(uint8_t** screen_start);
 int32_t sys_set_handler(int32_t signum, void* handler_address);
 int32_t sys_sigreturn(void);
+int32_t sys_fork(void);
+int32_t sys_setpriority(int32_t pid, int32_t priority);
+int32_t sys_readv(int32_t fd, const iovec_t* iov, int32_t iovcnt);
+int32_t sys_writev(int32_t fd, const iovec_t* iov, int32_t iovcnt);
+int32_t sys_pipe(int32_t* fds);
+int32_t sys_dup2(int32_t oldfd, int32_t newfd);
+int32_t sys_poll(pollfd_t* fds, int32_t nfds, int32_t timeout);
+
+// fast system call entry
+void sysenter_init(void);
+extern void sysenter_entry();
 
 // special syscalls
 int32_t execute_shell(uint32_t ter);
@@ -38,5 +63,6 @@ int32_t keyboard_halt(uint8_t active_ter);
 
 // switch context
 extern void iret_handler();
+extern void syscall_ret();
 
 #endif /*SYSTEM_CALL_H*/
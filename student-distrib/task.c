@@ -3,64 +3,249 @@
 #include "task.h"
 #include "pcb.h"
 #include "lib.h"
+#include "loader.h"
+#include "frame_alloc.h"
 
 uint32_t process_cnt = 0;  // there is always one shell
-uint8_t avail_pid = 0x0;    // bit mask for available pid
+uint32_t avail_pid[PID_WORDS];  // bit mask for available pid
+
+/* task_alloc
+ *
+ * Get the kernel memory of a pid: the kernel stack, page directory and
+ * user page table from frame_alloc, the pcb and fd table from their slab
+ * caches. It is kept for the
+ * next process that gets the pid, since a halting process is still
+ * running on its kernel stack when it gives the pid back.
+ * Inputs: pid -- the pid to set up
+ * Outputs: 0 on success, -1 if memory is exhausted
+ * Side Effects: fill pcb_table, process_page_directory and user_page_table
+ */
+static int32_t task_alloc(uint8_t pid){
+  uint32_t stack, page_dir, page_table;
+  pcb_t* pcb = NULL;
+  int i;
+  if (pcb_table[pid]) return 0;
+  stack = frame_alloc_pages(KSTACK_PAGES);
+  page_dir = frame_alloc();
+  page_table = frame_alloc();
+  if (stack) pcb = alloc_pcb(stack);
+  if (!pcb || !page_dir || !page_table) {
+    if (pcb) free_pcb(pcb);
+    if (stack) frame_free_pages(stack, KSTACK_PAGES);
+    if (page_dir) frame_free(page_dir);
+    if (page_table) frame_free(page_table);
+    return -1;
+  }
+  process_page_directory[pid] = (pde_t*)page_dir;
+  user_page_table[pid] = (pte_t*)page_table;
+  // the kernel entries are the same in every directory
+  for (i = 0; i < PG_NUM; i++) process_page_directory[pid][i] = page_directory[i];
+  memset(user_page_table[pid], 0, FRAME_SIZE);
+  process_page_directory[pid][MB_128_V_OFF].addr = page_table >> SHIFT_OFF;
+  process_page_directory[pid][MB_128_V_OFF].present = 1;
+  pcb_table[pid] = pcb;
+  return 0;
+}
 
 /* task_init
  *
- * Allocate page for the tasks
+ * Allocate page for the tasks, call with interrupts off
  * Inputs: None
- * Outputs: current_id (0-indexing) for this task's pcb_t
+ * Outputs: current_id (0-indexing) for this task's pcb_t, -1 if no pid or
+ *          memory is left
  * Side Effects: initialize paging tables
  */
 uint8_t task_init(){
-  cli();
-  uint8_t pid;
-  if(process_cnt >= MAX_PROCESS) return -1; //support up to 6 tasks
+  uint8_t pid = (uint8_t)-1;
+  if(process_cnt >= MAX_PROCESS) return -1;
   int i;
   // assign 
-  for (i = 0; i < MAX_PROCESS; i++) { //support up to 6 tasks
-    if (((avail_pid >> i) & PID_AVAIL) == 0) {
+  for (i = 0; i < MAX_PROCESS; i++) {
+    if (((avail_pid[i / 32] >> (i % 32)) & PID_AVAIL) == 0) {
       pid = i;
-      avail_pid |= (PID_AVAIL << pid);
       break;
     }
   }
-  page_directory[MB_128_V_OFF].addr = (MB_8 + pid * MB_4) >> SHIFT_OFF;
+  if (pid == (uint8_t)-1 || task_alloc(pid)) return -1;
+  avail_pid[pid / 32] |= (PID_AVAIL << (pid % 32));
+  // every page of the new image starts not present and is filled on first touch
+  for (i = 0; i < PG_NUM; i++) {
+    user_page_table[pid][i].present = 0;
+    user_page_table[pid][i].r_w = 1;
+    user_page_table[pid][i].u_s = 1;
+    user_page_table[pid][i].available = 0;
+    user_page_table[pid][i].addr = 0;
+  }
+  // a new program has not called vidmap yet
+  process_page_directory[pid][USER_VIDEO_V_OFF].present = 0;
   process_cnt++;
-  // Flush TLB after swapping page
-  flushTLB();
+  // the pid is not running, so its directory is not loaded and loading it
+  // drops the old entries of the rewritten table
+  task_switch_pg(pid);
   return (uint8_t)pid;
 }
 
+/* task_load_pg_dir
+ *
+ * Load a page directory into CR3 unless it is already there; the load
+ * drops only the non-global (user) TLB entries
+ * Inputs: page_dir -- page directory to load
+ * Outputs: the directory loaded before
+ * Side Effects: load CR3
+ */
+void* task_load_pg_dir(void* page_dir){
+  void* prev = getPageDirectory();
+  if (page_dir == prev) return prev;
+  loadPageDirectory((uint32_t*)page_dir);
+  return prev;
+}
+
+/* task_switch_pg
+ *
+ * Switch to a process's page directory
+ * Inputs: process_id -- the pid to switch to
+ * Outputs: None
+ * Side Effects: load CR3
+ */
+void task_switch_pg(uint8_t process_id){
+  (void)task_load_pg_dir(process_page_directory[process_id]);
+}
+
+/* task_map_page
+ *
+ * Give one 4KB page of a process's user program page a frame of its own
+ * Inputs: process_id -- owner of the page table
+ *         vaddr -- user virtual address inside the page
+ * Outputs: 0 on success, -1 if memory is exhausted
+ * Side Effects: set the PTE present and drop its stale TLB entry
+ */
+int32_t task_map_page(uint8_t process_id, uint32_t vaddr){
+  pte_t* pte = &user_page_table[process_id][(vaddr - MB_128_V_ADDR) >> SHIFT_OFF];
+  uint32_t frame = frame_alloc();
+  if (!frame) return -1;
+  pte->addr = frame >> SHIFT_OFF;
+  pte->r_w = 1;
+  pte->available = PTE_PRIVATE;
+  pte->present = 1;
+  invalidatePage(vaddr);
+  return 0;
+}
+
+/* task_map_readonly
+ *
+ * Map one 4KB page of a process's user program page to a frame it does not
+ * own, read only. Used to map filesystem blocks in place.
+ * Inputs: process_id -- owner of the page table
+ *         vaddr -- user virtual address inside the page
+ *         phys_addr -- page aligned physical address of the frame
+ * Outputs: None
+ * Side Effects: set the PTE and drop its stale TLB entry
+ */
+void task_map_readonly(uint8_t process_id, uint32_t vaddr, uint32_t phys_addr){
+  pte_t* pte = &user_page_table[process_id][(vaddr - MB_128_V_ADDR) >> SHIFT_OFF];
+  pte->addr = phys_addr >> SHIFT_OFF;
+  pte->r_w = 0;
+  pte->available = 0;
+  pte->present = 1;
+  invalidatePage(vaddr);
+}
+
 /* task_halt
  *
  * Called when the program is halted
- * Inputs: process_id -- current pid
+ * Inputs: process_id -- the halting pid, it may still be the loaded directory
  * Outputs: None
- * Side Effects: initialize paging tables
+ * Side Effects: free its user pages and the pid
  */
 void task_halt(uint8_t process_id){
+  int i;
   pcb_t* current_pcb = get_pcb_by_id(process_id);
   // printf("destroy pid: %d\n", process_id);
   // printf("pid_avail: %x\n", avail_pid);
 
-  avail_pid ^= (PID_AVAIL << process_id);
+  avail_pid[process_id / 32] &= ~(PID_AVAIL << (process_id % 32));
+  // drop the private and copy-on-write user pages, shared text is released below
+  for (i = 0; i < PG_NUM; i++) {
+    pte_t* pte = &user_page_table[process_id][i];
+    if (pte->present && pte->available) frame_free(pte->addr << SHIFT_OFF);
+    pte->present = 0;
+  }
+  // release the shared text frames if this was the last run of the program
+  exec_share_put(current_pcb -> text);
+  current_pcb -> text = NULL;
   // printf("mask: %x\n", PID_AVAIL << process_id);
 
   // printf("pid_avail: %x\n", avail_pid);
 
-  uint8_t pid = current_pcb -> parent_id;
-  page_directory[MB_128_V_OFF].addr = (MB_8 + pid * MB_4) >> SHIFT_OFF;
   // Decrement process_count
   process_cnt--;
-
-  // Flush TLB after swapping page
-  flushTLB();
   return;
 }
 
+/* task_fork_pg
+ *
+ * Give a forked child the parent's user pages copy-on-write: every
+ * writable page becomes read only in both processes and the frame gets a
+ * second reference. Shared text is mapped as is.
+ * Inputs: parent_id -- the forking process
+ *         child_id -- the new process, from task_init
+ * Outputs: 0
+ * Side Effects: change the parent's PTEs; its TLB entries were dropped when
+ *               task_init loaded the child's directory
+ */
+int32_t task_fork_pg(uint8_t parent_id, uint8_t child_id){
+  int i;
+  pte_t* parent_pte;
+  for (i = 0; i < PG_NUM; i++) {
+    parent_pte = &user_page_table[parent_id][i];
+    if (!parent_pte->present) continue;
+    if (parent_pte->available) {
+      parent_pte->r_w = 0;
+      parent_pte->available = PTE_COW;
+      frame_get(parent_pte->addr << SHIFT_OFF);
+    }
+    user_page_table[child_id][i] = *parent_pte;
+  }
+  // vidmap carries over
+  process_page_directory[child_id][USER_VIDEO_V_OFF].present =
+    process_page_directory[parent_id][USER_VIDEO_V_OFF].present;
+  return 0;
+}
+
+/* task_cow_fault
+ *
+ * Handle a write to a copy-on-write page of the current process, from user
+ * mode or from the kernel writing to a user buffer. The last process
+ * holding the frame just gets it back writable, others get a copy.
+ * Inputs: addr -- faulting address from CR2
+ *         err -- page fault error code
+ * Outputs: Return 0 if the fault was handled
+ *          Return -1 if it is not a copy-on-write fault or memory is exhausted
+ * Side Effects: May allocate and copy a frame, update the PTE
+ */
+int32_t task_cow_fault(uint32_t addr, uint32_t err){
+  pcb_t* cur_pcb;
+  pte_t* pte;
+  uint32_t old_frame, new_frame;
+  if (addr < MB_128_V_ADDR || addr >= MB_128_V_ADDR + MB_4) return -1;
+  if (!(err & PF_PRESENT) || !(err & PF_WRITE) || process_cnt == 0) return -1;
+  cur_pcb = get_pcb();
+  pte = &user_page_table[cur_pcb->current_id][(addr - MB_128_V_ADDR) >> SHIFT_OFF];
+  if (!pte->present || pte->available != PTE_COW) return -1;
+  old_frame = pte->addr << SHIFT_OFF;
+  if (frame_ref_count(old_frame) > 1) {
+    new_frame = frame_alloc();
+    if (!new_frame) return -1;
+    memcpy((void*)new_frame, (void*)old_frame, USER_PG_SIZE);
+    frame_free(old_frame);
+    pte->addr = new_frame >> SHIFT_OFF;
+  }
+  pte->available = PTE_PRIVATE;
+  pte->r_w = 1;
+  invalidatePage(addr);
+  return 0;
+}
+
 /* get_process_cnt
  *
  * get process count
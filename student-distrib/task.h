@@ -5,10 +5,21 @@
 
 #define MB_4 0x400000
 #define PID_AVAIL 0x1
-#define MAX_PROCESS 6
+#define MAX_PROCESS 255     // pids are uint8_t, 0xFF means no process
+#define PID_WORDS ((MAX_PROCESS + 31) / 32)
+#define KSTACK_PAGES 2      // pcb and kernel stack, 8KB aligned
+#define PTE_PRIVATE 0x1     // PTE available bits: frame belongs to the process
+#define PTE_COW 0x2         // PTE available bits: frame shared after fork, copy on write
+#define PF_WRITE 0x2        // page fault error code: write access
 
 uint8_t task_init();
 void task_halt(uint8_t process_id);
+void task_switch_pg(uint8_t process_id);
+void* task_load_pg_dir(void* page_dir);
+int32_t task_map_page(uint8_t process_id, uint32_t vaddr);
+void task_map_readonly(uint8_t process_id, uint32_t vaddr, uint32_t phys_addr);
+int32_t task_fork_pg(uint8_t parent_id, uint8_t child_id);
+int32_t task_cow_fault(uint32_t addr, uint32_t err);
 uint32_t get_process_cnt();
 
 // flush TLB
@@ -4,6 +4,7 @@
 #include "x86_desc.h"
 #include "pcb.h"
 #include "system_call.h"
+#include "wait_queue.h"
 
 static char* video_mem = (char *)VIDEO;
 // static unsigned int cur_ter = 0;
@@ -200,11 +201,14 @@ int32_t terminal_read(int32_t fd, void* buf, int32_t length){
     count=0;
     pcb_t* cur_pcb = get_pcb_by_id(active_process);
     uint8_t process_ter = cur_pcb->terminal;
-    if(buf_status[process_ter]!=1){    // if the previous buffer is closed, open it
+    uint32_t flags;
+    if(buf_status[process_ter]==BUF_CLOSED){    // if the previous buffer is closed, open it
         key_buf_clear(process_ter);
-        buf_status[process_ter]=1;
+        buf_status[process_ter]=BUF_OPEN;
     }
-    while(buf_status[process_ter]==1);   // wait the user to input
+    cli_and_save(flags);
+    while(buf_status[process_ter]==BUF_OPEN) sleep_on(&read_wait[process_ter]);   // wait the user to input
+    restore_flags(flags);
     printf("\n");
     cli();
     for(i=0; i<length; i++){      // write to buffer
@@ -221,10 +225,42 @@ int32_t terminal_read(int32_t fd, void* buf, int32_t length){
     if (i == length){
       buf_read[i - 1] = '\n';
     }
+    buf_status[process_ter]=BUF_CLOSED;    // the line is taken
     sti();
     return count;
 }
 
+/* terminal_poll(int32_t fd)
+ *
+ *  check whether a read or write would block, called with interrupts off
+ * Inputs:  int32_t fd -> file descriptor
+ * Outputs: int -> POLLOUT, and POLLIN once a line was entered
+ * Side Effects: None, the keyboard wakes pollers on enter
+ */
+int32_t terminal_poll(int32_t fd){
+    pcb_t* cur_pcb = get_pcb_by_id(active_process);
+    if (buf_status[cur_pcb->terminal] == BUF_LINE) return POLLIN | POLLOUT;
+    return POLLOUT;
+}
+
+/* terminal_put(const void* buf, int32_t length)
+ *
+ *  print a buffer without moving the cursor, call with interrupts off
+ * Inputs:  buf -> the text
+ *          length -> its length
+ * Outputs: int -> the printed bytes
+ * Side Effects: None
+ */
+static int32_t terminal_put(const void* buf, int32_t length){
+    int count = 0;
+    int i;
+    for(i=0;i<length;i++){
+        printf("%c",((int8_t*)buf)[i]);
+        count++;
+    }
+    return count;
+}
+
 /* terminal_write(char* buf,unsigned int length)
  *
  *  start to write to keyboard buffer
@@ -234,17 +270,34 @@ int32_t terminal_read(int32_t fd, void* buf, int32_t length){
  * Side Effects: None
  */
 int32_t terminal_write(int32_t fd, const void* buf, int32_t length){
-    cli();
     if (!buf) return -1;  // if buf is null, return -1
-    int count = 0;  // writed byte to keyboard buffer
-    // int8_t* buf_write = (int8_t*) buf;
+    cli();
+    int count = terminal_put(buf, length);
+    // the cursor only has to end up after the text
+    update_cursor_ter(get_y()*NUM_COLS+get_x()); /*fix*/
+    sti();
+    return count;
+}
+
+/* terminal_writev(int32_t fd, const iovec_t* iov, int32_t iovcnt)
+ *
+ *  write several buffers to the screen as one piece of text
+ * Inputs:  iov -> the buffers
+ *          iovcnt -> how many there are
+ * Outputs: int -> the written bytes, -1 if a buffer is null
+ * Side Effects: one cursor update and one cli/sti for all the buffers
+ */
+int32_t terminal_writev(int32_t fd, const iovec_t* iov, int32_t iovcnt){
+    int count = 0;
     int i;
-    for(i=0;i<length;i++){
-        // if(((int8_t*)buf)[i]==NULL){continue;}
-        printf("%c",((int8_t*)buf)[i]);
-        count++;
-        update_cursor_ter(get_y()*NUM_COLS+get_x()); /*fix*/
+    for (i = 0; i < iovcnt; i++) {
+        if (!iov[i].base) return -1;
+    }
+    cli();
+    for (i = 0; i < iovcnt; i++) {
+        count += terminal_put(iov[i].base, iov[i].len);
     }
+    update_cursor_ter(get_y()*NUM_COLS+get_x());
     sti();
     return count;
 }
@@ -260,7 +313,7 @@ void switch_video(unsigned int ter){
     cli();
     if(ter<0 || ter>=TER_NUM) return;
     video_mem_page_table[VIDEO_START_OFF].addr = VIDEO_START_OFF;
-    flushTLB();
+    invalidatePage(VIDEO_MEM_ADDR);
     int8_t* tar = (int8_t*)(VIDEO + (ter+1)* VIDEO_SIZE);
     int8_t* cur = (int8_t*)(VIDEO + (active_ter+1)*VIDEO_SIZE);
     // we copy the current terminal to the buffer
@@ -273,7 +326,7 @@ void switch_video(unsigned int ter){
     pcb_t* active_pcb = get_pcb_by_id(active_process);
     uint8_t restore_ter = active_pcb -> terminal;
     video_mem_page_table[VIDEO_START_OFF].addr = VIDEO_START_OFF + restore_ter + 1;
-    flushTLB();
+    invalidatePage(VIDEO_MEM_ADDR);
     return;
 }
 
@@ -48,3 +48,5 @@ int32_t terminal_open(const int8_t* fname);
 int32_t terminal_close(int32_t fd);
 int32_t terminal_read(int32_t fd, void* buf, int32_t length);
 int32_t terminal_write(int32_t fd, const void* buf, int32_t length);
+int32_t terminal_writev(int32_t fd, const iovec_t* iov, int32_t iovcnt);
+int32_t terminal_poll(int32_t fd);
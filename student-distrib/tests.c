@@ -7,6 +7,11 @@
 #include "idt.h"
 #include "terminal_driver.h"
 #include "file_sys_driver.h"
+#include "paging_init.h"
+#include "task.h"
+#include "frame_alloc.h"
+#include "slab.h"
+#include "scheduler.h"
 
 #define PASS 1
 #define FAIL 0
@@ -512,6 +517,395 @@ int rtc_read_write_test(){
 /* Checkpoint 4 tests */
 /* Checkpoint 5 tests */
 
+/* Performance tests */
+
+/* linear_dentry_lookup
+ *
+ * The original read_dentry_by_name scan, kept as the baseline for the
+ * lookup benchmark
+ * Inputs: fname -- the name of the target file
+ * Outputs: the dentry index, -1 if not found
+ */
+static int32_t linear_dentry_lookup(const uint8_t* fname){
+	int32_t index;
+	int8_t* cur_fname;
+	int32_t f_len = strlen((int8_t*) fname);
+	for (index = 0; index < b_block_addr->inode_cnt; index++){
+		cur_fname = dentry_addr[index].filename;
+		int32_t cur_len = strlen((int8_t*) cur_fname);
+		if (cur_len > NAME_SIZE) cur_len = NAME_SIZE;
+		int32_t len = (cur_len > f_len) ? cur_len : f_len;
+		if (!strncmp((int8_t*) fname, cur_fname, len)) return index;
+	}
+	return -1;
+}
+
+/* dentry_lookup_bench
+ *
+ * Time name lookups of every file plus a miss, with the old linear scan
+ * and with the name index
+ * Inputs: None
+ * Outputs: PASS if both lookups agree on every name
+ * Side Effects: Print cycles per lookup
+ * Coverage: read_dentry_by_name, lookup_dentry_index
+ * Files: file_sys_driver.c
+ */
+int dentry_lookup_bench(){
+	TEST_HEADER;
+	uint8_t names[DENTRY_NUM + 1][NAME_SIZE + 1];
+	int32_t name_cnt = b_block_addr->dir_cnt;
+	int32_t i, round;
+	uint32_t start, linear_cycles, hash_cycles;
+	int result = PASS;
+	if (name_cnt > DENTRY_NUM) name_cnt = DENTRY_NUM;
+	for (i = 0; i < name_cnt; i++){
+		memcpy(names[i], dentry_addr[i].filename, NAME_SIZE);
+		names[i][NAME_SIZE] = '\0';
+	}
+	strcpy((int8_t*)names[name_cnt], (int8_t*)MISS_NAME);
+	name_cnt++;
+	// check the index agrees with the linear scan before timing
+	for (i = 0; i < name_cnt; i++){
+		if (linear_dentry_lookup(names[i]) != lookup_dentry_index(names[i])){
+			printf("mismatch on %s\n", names[i]);
+			result = FAIL;
+		}
+	}
+	start = rdtsc_low();
+	for (round = 0; round < LOOKUP_ROUNDS; round++)
+		for (i = 0; i < name_cnt; i++) (void)linear_dentry_lookup(names[i]);
+	linear_cycles = rdtsc_low() - start;
+	start = rdtsc_low();
+	for (round = 0; round < LOOKUP_ROUNDS; round++)
+		for (i = 0; i < name_cnt; i++) (void)lookup_dentry_index(names[i]);
+	hash_cycles = rdtsc_low() - start;
+	printf("linear scan: %u cycles/lookup\n", linear_cycles / (LOOKUP_ROUNDS * name_cnt));
+	printf("name index:  %u cycles/lookup\n", hash_cycles / (LOOKUP_ROUNDS * name_cnt));
+	return result;
+}
+
+// scratch buffer for the read benchmark, too large for the stack
+static uint8_t bench_buf[FIL_BUF];
+
+/* bytewise_read_data
+ *
+ * The original per-byte read_data loop, kept as the baseline for the
+ * read throughput benchmark
+ * Inputs: same as read_data
+ * Outputs: the bytes read, -1 on error
+ */
+static int32_t bytewise_read_data(uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length){
+	inode_t file_inode = inode_start_addr[inode];
+	uint32_t file_len = file_inode.length;
+	uint32_t buf_idx, block_off, block_idx, data_idx;
+	if (offset > file_len) return -1;
+	if ((offset + length) > file_len) length = file_len - offset;
+	for (buf_idx = 0; buf_idx < length; buf_idx++){
+		data_idx = (offset + buf_idx) % BLOCK_SIZE;
+		block_off = (offset + buf_idx) / BLOCK_SIZE;
+		if (block_off >= b_block_addr->data_cnt) return -1;
+		block_idx = file_inode.data_block_num[block_off];
+		buf[buf_idx] = d_block_start_addr[block_idx].data[data_idx];
+	}
+	return buf_idx;
+}
+
+/* tsc_khz
+ *
+ * Calibrate the time-stamp counter against the 1024 Hz RTC
+ * Inputs: None
+ * Outputs: TSC frequency in kHz
+ * Side Effects: Waits CALIBRATE_TICKS RTC interrupts, needs interrupts on
+ */
+static uint32_t tsc_khz(){
+	int32_t tick;
+	uint32_t start, per_tick;
+	tick = tick_counter;
+	while (tick_counter == tick);
+	tick = tick_counter;
+	start = rdtsc_low();
+	while (tick_counter - tick < CALIBRATE_TICKS);
+	per_tick = (rdtsc_low() - start) / CALIBRATE_TICKS;
+	return per_tick + per_tick / KHZ_DEN * KHZ_NUM;
+}
+
+/* read_bench_file
+ *
+ * Read a whole file READ_ROUNDS times with one read function and
+ * print the throughput
+ * Inputs: fname -- file to read
+ *         read_fn -- read_data or the bytewise baseline
+ *         khz -- TSC frequency
+ * Outputs: the file length, -1 if the file cannot be read
+ * Side Effects: Print the throughput
+ */
+static int32_t read_bench_file(const int8_t* fname, int32_t (*read_fn)(uint32_t, uint32_t, uint8_t*, uint32_t), uint32_t khz){
+	dentry_t dentry;
+	int32_t i, len = 0;
+	uint32_t start, cycles, per_kb;
+	if (read_dentry_by_name((uint8_t*)fname, &dentry)) return -1;
+	start = rdtsc_low();
+	for (i = 0; i < READ_ROUNDS; i++){
+		len = read_fn(dentry.inode_num, 0, bench_buf, FIL_BUF);
+		if (len < 0) return -1;
+	}
+	cycles = rdtsc_low() - start;
+	per_kb = cycles / (((uint32_t)len * READ_ROUNDS >> KB_SHIFT) + 1);
+	// KB per ms is close enough to MB/s for a comparison
+	printf("    %s: %u cycles/KB, %u MB/s\n", fname, per_kb, per_kb ? khz / per_kb : 0);
+	return len;
+}
+
+/* read_data_bench
+ *
+ * Compare read throughput of the bytewise baseline and the block
+ * walking read_data on a large text file and a large binary
+ * Inputs: None
+ * Outputs: PASS if both reads return the same length
+ * Side Effects: Print MB/s for each file and method
+ * Coverage: read_data
+ * Files: file_sys_driver.c
+ */
+int read_data_bench(){
+	TEST_HEADER;
+	uint32_t khz = tsc_khz();
+	int32_t old_text, old_fish, new_text, new_fish;
+	printf("TSC: %u kHz\n", khz);
+	printf("bytewise read_data:\n");
+	old_text = read_bench_file((int8_t*)LARGE_TEXT, bytewise_read_data, khz);
+	old_fish = read_bench_file((int8_t*)FISH_BIN, bytewise_read_data, khz);
+	printf("block read_data:\n");
+	new_text = read_bench_file((int8_t*)LARGE_TEXT, read_data, khz);
+	new_fish = read_bench_file((int8_t*)FISH_BIN, read_data, khz);
+	return (old_text == new_text && old_fish == new_fish && new_text > 0 && new_fish > 0) ? PASS : FAIL;
+}
+
+/* touch_video_pages
+ *
+ * Read one word from each video page so its TLB entry is refilled
+ * Inputs: None
+ * Outputs: the sum of the words read
+ */
+static uint32_t touch_video_pages(){
+	uint32_t i, sum = 0;
+	for (i = 0; i < TOUCH_PAGES; i++)
+		sum += *(volatile uint32_t*)(VIDEO_MEM_ADDR + i * VIDEO_SIZE);
+	return sum;
+}
+
+/* context_switch_bench
+ *
+ * Compare the paging part of a context switch: the old way rewrote the
+ * user PDE of the single page directory and reloaded CR3, now each process
+ * has its own directory and the kernel and video entries are global
+ * Inputs: None
+ * Outputs: PASS if the frames for two directories could be allocated
+ * Side Effects: Print cycles per switch
+ * Coverage: task_load_pg_dir
+ * Files: task.c, paging_init.c
+ */
+int context_switch_bench(){
+	TEST_HEADER;
+	uint32_t i, j, start, old_cycles, new_cycles;
+	pde_t* dirs[2];
+	pde_t user_pde;
+	void* prev;
+	void* kernel_dir = page_directory;
+	dirs[0] = (pde_t*)frame_alloc();
+	dirs[1] = (pde_t*)frame_alloc();
+	if (!dirs[0] || !dirs[1]){
+		if (dirs[0]) frame_free((uint32_t)dirs[0]);
+		return FAIL;
+	}
+	for (i = 0; i < 2; i++)
+		for (j = 0; j < PG_NUM; j++) dirs[i][j] = page_directory[j];
+	cli();
+	user_pde = page_directory[MB_128_V_OFF];
+	start = rdtsc_low();
+	for (i = 0; i < SWITCH_ROUNDS; i++){
+		// any two table addresses do, the user page is never touched
+		page_directory[MB_128_V_OFF].addr = (uint32_t)dirs[i & 1] >> SHIFT_OFF;
+		loadPageDirectory(kernel_dir);
+		(void)touch_video_pages();
+	}
+	old_cycles = rdtsc_low() - start;
+	page_directory[MB_128_V_OFF] = user_pde;
+	prev = task_load_pg_dir(dirs[0]);
+	start = rdtsc_low();
+	for (i = 0; i < SWITCH_ROUNDS; i++){
+		(void)task_load_pg_dir(dirs[i & 1]);
+		(void)touch_video_pages();
+	}
+	new_cycles = rdtsc_low() - start;
+	(void)task_load_pg_dir(prev ? prev : page_directory);
+	sti();
+	frame_free((uint32_t)dirs[0]);
+	frame_free((uint32_t)dirs[1]);
+	printf("PDE rewrite + CR3 reload: %u cycles/switch\n", old_cycles / SWITCH_ROUNDS);
+	printf("per-process directory:    %u cycles/switch\n", new_cycles / SWITCH_ROUNDS);
+	return PASS;
+}
+
+/* frame_alloc_test
+ *
+ * Allocate frames until memory runs out, check every frame is unique,
+ * aligned, inside the managed range and writable, then free them all
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None, all frames are returned
+ * Coverage: frame_alloc, frame_alloc_pages, frame_free
+ * Files: frame_alloc.c
+ */
+int frame_alloc_test(){
+	TEST_HEADER;
+	int result = PASS;
+	uint32_t before = frame_free_count();
+	uint32_t frame, prev = 0, cnt = 0, pair;
+	// chain the frames through their first word so no table is needed
+	while ((frame = frame_alloc())){
+		if ((frame & (FRAME_SIZE - 1)) || frame < FRAME_START || frame >= FRAME_LIMIT) result = FAIL;
+		*(uint32_t*)frame = prev;
+		prev = frame;
+		cnt++;
+	}
+	printf("%u frames, %u MB free\n", cnt, cnt >> (20 - FRAME_SHIFT));
+	if (cnt != before || frame_free_count() != 0) result = FAIL;
+	while (prev){
+		frame = *(uint32_t*)prev;
+		frame_free(prev);
+		prev = frame;
+	}
+	if (frame_free_count() != before) result = FAIL;
+	pair = frame_alloc_pages(KSTACK_PAGES);
+	if (!pair || (pair & (KSTACK_PAGES * FRAME_SIZE - 1))) result = FAIL;
+	frame_free_pages(pair, KSTACK_PAGES);
+	if (frame_free_count() != before) result = FAIL;
+	return result;
+}
+
+/* slab_test
+ *
+ * kmalloc objects of several sizes, fill each with a pattern, check none
+ * overlap and all come back to the same free frame count after kfree
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None, all memory is returned
+ * Coverage: kmalloc, kfree
+ * Files: slab.c
+ */
+int slab_test(){
+	TEST_HEADER;
+	static uint8_t* objs[SLAB_TEST_OBJS];
+	uint32_t sizes[SLAB_TEST_SIZES] = {12, 100, 700, KMALLOC_MAX};
+	uint32_t i, j, before;
+	int result = PASS;
+	// the first run may keep one spare slab per class, so warm up first
+	for (i = 0; i < SLAB_TEST_SIZES; i++) kfree(kmalloc(sizes[i]));
+	before = frame_free_count();
+	for (i = 0; i < SLAB_TEST_OBJS; i++){
+		objs[i] = kmalloc(sizes[i % SLAB_TEST_SIZES]);
+		if (!objs[i] || ((uint32_t)objs[i] & (SLAB_ALIGN - 1))) return FAIL;
+		memset(objs[i], i & 0xFF, sizes[i % SLAB_TEST_SIZES]);
+	}
+	for (i = 0; i < SLAB_TEST_OBJS; i++)
+		for (j = 0; j < sizes[i % SLAB_TEST_SIZES]; j++)
+			if (objs[i][j] != (i & 0xFF)) result = FAIL;
+	for (i = 0; i < SLAB_TEST_OBJS; i++) kfree(objs[i]);
+	if (frame_free_count() != before) result = FAIL;
+	if (kmalloc(0) || kmalloc(KMALLOC_MAX + 1)) result = FAIL;
+	return result;
+}
+
+/* syscall_bench
+ *
+ * Time the round trip of a system call that fails at once, a read of fd -1,
+ * made with int $0x80 from the kernel: the trap, the dispatch in
+ * syscall_handler_asm and the return
+ * Inputs: None
+ * Outputs: PASS if the call returned -1
+ * Side Effects: Print cycles per call
+ * Coverage: syscall_handler_asm, sys_read
+ * Files: interrupt_wrapper.S, system_call.c
+ */
+int syscall_bench(){
+	TEST_HEADER;
+	uint32_t i, start, cycles;
+	int32_t ret = 0;
+	start = rdtsc_low();
+	for (i = 0; i < SYSCALL_ROUNDS; i++){
+		asm volatile ("int $0x80"
+				: "=a"(ret)
+				: "a"(BENCH_SYSCALL), "b"(-1), "c"(0), "d"(0)
+				: "memory", "cc");
+	}
+	cycles = rdtsc_low() - start;
+	printf("int $0x80 read(-1):       %u cycles/call\n", cycles / SYSCALL_ROUNDS);
+	return ret == -1 ? PASS : FAIL;
+}
+
+// the other side of the switch_to benchmark
+static uint32_t bench_main_sp, bench_peer_sp;
+static uint32_t bench_peer_stack[BENCH_STACK_WORDS];
+
+/* switch_peer
+ *
+ * Runs on bench_peer_stack and switches straight back, forever
+ * Inputs: None
+ * Outputs: None
+ */
+static void switch_peer(){
+	while (1) switch_to(&bench_peer_sp, bench_main_sp, tss.esp0, getPageDirectory());
+}
+
+/* switch_to_bench
+ *
+ * Time switch_to between two kernel stacks that share a page directory,
+ * so it is the register and stack part of a context switch only
+ * Inputs: None
+ * Outputs: PASS
+ * Side Effects: Print cycles per switch
+ * Coverage: switch_to
+ * Files: interrupt_wrapper.S
+ */
+int switch_to_bench(){
+	TEST_HEADER;
+	uint32_t i, start, cycles;
+	uint32_t* top = &bench_peer_stack[BENCH_STACK_WORDS];
+	void* dir = getPageDirectory();
+	// the first switch returns into switch_peer, as if it had been called
+	memset(bench_peer_stack, 0, sizeof(bench_peer_stack));
+	top[-2] = (uint32_t)switch_peer;
+	bench_peer_sp = (uint32_t)&top[-2 - SWITCH_SAVED_REGS];
+	cli();
+	start = rdtsc_low();
+	for (i = 0; i < SWITCH_ROUNDS; i++)
+		switch_to(&bench_main_sp, bench_peer_sp, tss.esp0, dir);
+	cycles = rdtsc_low() - start;
+	sti();
+	printf("switch_to:                %u cycles/switch\n", cycles / (2 * SWITCH_ROUNDS));
+	return PASS;
+}
+
+/* regression_bench
+ *
+ * Run the benchmarks without waiting for the keyboard and power QEMU off.
+ * Used when booted with "bench" on the command line, before the scheduler
+ * starts; regress.sh compares the cycle counts of two builds.
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: Print the timings, exit QEMU if it has an isa-debug-exit
+ *               device, return otherwise
+ */
+void regression_bench(){
+	TEST_OUTPUT("syscall_bench", syscall_bench());
+	TEST_OUTPUT("switch_to_bench", switch_to_bench());
+	TEST_OUTPUT("context_switch_bench", context_switch_bench());
+	TEST_OUTPUT("dentry_lookup_bench", dentry_lookup_bench());
+	TEST_OUTPUT("read_data_bench", read_data_bench());
+	printf("All benchmarks executed.\n");
+	outb(QEMU_EXIT_OK, QEMU_EXIT_PORT);
+}
+
 /* Test suite entry point
  * Uncomment one test at a time to check for the functionalities.
  *
@@ -563,6 +957,15 @@ void launch_tests(){
 	// test_wrapper_int("read file test: small 2", file_read_syscall_test, FRAME1); // Test print small 2
 	// test_wrapper_int("read file test edge case: small buffer", file_read_syscall_edge_test, FRAME0); // Test small buffer
 
+/* Performance tests */
+	// test_wrapper_no_param("syscall benchmark", syscall_bench);
+	// test_wrapper_no_param("switch_to benchmark", switch_to_bench);
+	// test_wrapper_no_param("dentry lookup benchmark", dentry_lookup_bench);
+	// test_wrapper_no_param("read_data throughput benchmark", read_data_bench);
+	// test_wrapper_no_param("context switch benchmark", context_switch_bench);
+	// TEST_OUTPUT("frame_alloc_test", frame_alloc_test());
+	// TEST_OUTPUT("slab_test", slab_test());
+
 	// End testing
 	printf("All tests executed.");
 }
@@ -4,6 +4,9 @@
 // test launcher
 void launch_tests();
 
+// timings compared between builds by regress.sh
+void regression_bench();
+
 #define TEST_PERIOD 3
 
 // Video memory offset
@@ -50,4 +53,24 @@ void launch_tests();
 #define RTC_VALID_1 2
 #define RTC_VALID_2 1024
 
+// Benchmarks
+#define LOOKUP_ROUNDS 1000
+#define MISS_NAME "no_such_file"
+#define READ_ROUNDS 50
+#define CALIBRATE_TICKS 64
+#define KHZ_NUM 24      // 1024 Hz ticks: kHz = cycles/tick * 1024 / 1000
+#define KHZ_DEN 1000
+#define KB_SHIFT 10
+#define LARGE_TEXT "verylargetextwithverylongname.tx"  // names are cut to 32 bytes
+#define FISH_BIN "fish"
+#define SWITCH_ROUNDS 10000
+#define TOUCH_PAGES 4           // video page and the three terminal buffers
+#define SLAB_TEST_OBJS 300      // enough to need several slabs per size class
+#define SLAB_TEST_SIZES 4
+#define SYSCALL_ROUNDS 10000
+#define BENCH_SYSCALL 3         // read, called with fd -1 so it fails at once
+#define BENCH_STACK_WORDS 256
+#define QEMU_EXIT_PORT 0xF4     // isa-debug-exit device
+#define QEMU_EXIT_OK 0x10
+
 #endif /* TESTS_H */
@@ -0,0 +1,124 @@
+/* wait_queue.c - Functions used to put processes to sleep until an event
+ */
+
+#include "wait_queue.h"
+#include "scheduler.h"
+#include "lib.h"
+
+/* sleep_on
+ *
+ * Block the current process on a wait queue until it is woken. The caller
+ * checks its condition with interrupts off first, so a wake up from an
+ * interrupt handler cannot be lost in between.
+ * Inputs: wq -- the queue
+ * Outputs: None
+ * Side Effects: switch process, restores the interrupt flag on return
+ */
+void sleep_on(wait_queue_t* wq){
+    uint32_t flags;
+    pcb_t* pcb;
+    cli_and_save(flags);
+    pcb = sched_current();
+    if (pcb) {
+        pcb -> state = TASK_BLOCKED;
+        pcb -> wait_q = wq;
+        pcb -> wait_next = NULL;
+        if (wq -> tail) wq -> tail -> wait_next = pcb;
+        else wq -> head = pcb;
+        wq -> tail = pcb;
+        schedule();
+    }
+    restore_flags(flags);
+}
+
+/* wake_up
+ *
+ * Wake the process that has slept longest on a queue
+ * Inputs: wq -- the queue
+ * Outputs: None
+ * Side Effects: change the run queue
+ */
+void wake_up(wait_queue_t* wq){
+    uint32_t flags;
+    pcb_t* pcb;
+    cli_and_save(flags);
+    pcb = wq -> head;
+    if (pcb) {
+        wq -> head = pcb -> wait_next;
+        if (!wq -> head) wq -> tail = NULL;
+        pcb -> wait_q = NULL;
+        pcb -> wait_next = NULL;
+        // it was waiting on I/O, give it a boost
+        pcb -> boost = 1;
+        sched_wake(pcb);
+    }
+    restore_flags(flags);
+}
+
+/* wake_up_all
+ *
+ * Wake every process sleeping on a queue
+ * Inputs: wq -- the queue
+ * Outputs: None
+ * Side Effects: change the run queue
+ */
+void wake_up_all(wait_queue_t* wq){
+    uint32_t flags;
+    cli_and_save(flags);
+    while (wq -> head) wake_up(wq);
+    restore_flags(flags);
+}
+
+/* wait_queue_remove
+ *
+ * Take a process off the queue it sleeps on, if any, without waking it
+ * Inputs: pcb -- the process
+ * Outputs: None
+ * Side Effects: change the wait queue
+ */
+void wait_queue_remove(pcb_t* pcb){
+    uint32_t flags;
+    wait_queue_t* wq;
+    pcb_t* prev = NULL;
+    pcb_t* cur;
+    cli_and_save(flags);
+    wq = pcb -> wait_q;
+    if (wq) {
+        for (cur = wq -> head; cur && cur != pcb; cur = cur -> wait_next) prev = cur;
+        if (cur) {
+            if (prev) prev -> wait_next = pcb -> wait_next;
+            else wq -> head = pcb -> wait_next;
+            if (wq -> tail == pcb) wq -> tail = prev;
+        }
+        pcb -> wait_q = NULL;
+        pcb -> wait_next = NULL;
+    }
+    restore_flags(flags);
+}
+
+// processes blocked in poll, whatever fds they wait for
+static wait_queue_t poll_wait;
+
+/* poll_sleep
+ *
+ * Block the current process until some fd may have become ready. Like
+ * sleep_on, check the fds with interrupts off first.
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: switch process
+ */
+void poll_sleep(void){
+    sleep_on(&poll_wait);
+}
+
+/* poll_wake
+ *
+ * Wake every process in poll so they check their fds again. Cheap when
+ * nobody polls, so drivers call it on every state change.
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: change the run queue
+ */
+void poll_wake(void){
+    if (poll_wait.head) wake_up_all(&poll_wait);
+}
@@ -0,0 +1,33 @@
+/* wait_queue.h - Defines used to put processes to sleep until an event
+ */
+
+#ifndef _WAIT_QUEUE_H
+#define _WAIT_QUEUE_H
+
+#include "types.h"
+#include "x86_desc.h"
+
+// Processes sleeping on an event, in the order they went to sleep. The
+// links live in the pcb, a process sleeps on one queue at a time.
+typedef struct wait_queue {
+    pcb_t* head;
+    pcb_t* tail;
+} wait_queue_t;
+
+// Block the current process on a queue; check the condition with
+// interrupts off before calling and again after it returns
+void sleep_on(wait_queue_t* wq);
+
+// Make sleepers runnable again, callable from interrupt handlers
+void wake_up(wait_queue_t* wq);
+void wake_up_all(wait_queue_t* wq);
+
+// Take a process that is being killed off the queue it sleeps on
+void wait_queue_remove(pcb_t* pcb);
+
+// Processes in poll sleep on one shared queue, any fd that may have
+// become ready wakes them to look again
+void poll_sleep(void);
+void poll_wake(void);
+
+#endif /* _WAIT_QUEUE_H */
@@ -56,6 +56,8 @@
 
 #ifndef ASM
 
+#include "loader.h"
+
 /* This structure is used to load descriptor base registers
  * like the GDTR and IDTR */
 typedef struct x86_desc {
@@ -222,20 +224,46 @@ typedef struct data_block{
     uint8_t data[DATA_BLOCK_LENGTH];
 }data_block_t;
 
+// One buffer of a readv or writev
+typedef struct iovec{
+    void* base;
+    int32_t len;
+} iovec_t;
+
+// Events a poll asks for and gets back
+#define POLLIN   0x01  // a read will not block
+#define POLLOUT  0x04  // a write will not block
+#define POLLERR  0x08  // writing to a pipe nobody reads, always reported
+#define POLLHUP  0x10  // reading a pipe nobody writes, always reported
+#define POLLNVAL 0x20  // fd is not open, always reported
+
+// One fd of a poll
+typedef struct pollfd{
+    int32_t fd;         // negative ones are skipped
+    int16_t events;
+    int16_t revents;
+} pollfd_t;
+
 // The data structure for file operation table
 typedef struct file_op_table{
     int32_t (*open)(const uint8_t*);
     int32_t (*read)(int32_t, void*, int32_t);
     int32_t (*write)(int32_t, const void*, int32_t);
     int32_t (*close)(int32_t);
+    // optional, writev calls write per buffer when it is NULL
+    int32_t (*writev)(int32_t, const iovec_t*, int32_t);
+    // optional, returns the POLL events that are ready and makes sure
+    // poll_wake runs when one may become ready; NULL is always ready
+    int32_t (*poll)(int32_t);
 } file_op_table_t;
 
 // The structure for file descriptor
 typedef struct file_descriptor{
     file_op_table_t* file_op_table_ptr;
-    int32_t inode_idx; // 0 for directories and RTC
-    int32_t file_pos; // saves virtual freq in rtc type
+    int32_t inode_idx; // 0 for directories, tick of the last read for RTC
+    int32_t file_pos; // saves virtual freq in rtc type, the end of a pipe
     int32_t flag;
+    struct pipe* pipe; // pipe of a pipe end, NULL for other files
 } fd_t;
 
 /* Data structures to handle signals */
@@ -257,16 +285,37 @@ typedef struct sighand{
 } sighand_t;
 
 typedef struct process_contrl_block{
-    fd_t fd_array[8]; // up to 8 file at most
+    fd_t* fd_array; // up to 8 file at most, from the fd table cache
+    uint32_t kernel_stack;  // base of the 8KB kernel stack, holds a pointer back to the pcb
     uint8_t current_id;    // current process idber
     uint8_t parent_id;  //parent process number for return
     uint32_t parent_pointer;
-    uint32_t stack_p;   // stack pointer saved
-    uint32_t stack_bp;  // stack base pointer
-    uint32_t stack_switch_p;   // stack pointer saved
-    uint32_t stack_switch_bp;  // stack base pointer
+    uint32_t stack_switch_p;   // kernel stack pointer saved by switch_to
     uint8_t argument[128]; // arguments
     uint8_t terminal;
+    exec_info_t exec;   // program image, used to fill user pages on fault
+    text_share_t* text; // read-only pages shared with other runs of the program
+
+    // Scheduling
+    uint8_t state;      // TASK_DEAD, TASK_RUNNABLE or TASK_BLOCKED
+    uint8_t wait_pid;   // child a blocked execute waits for
+    int32_t child_status;   // halt status of that child
+    uint8_t priority;   // 0 runs first, SCHED_PRIO_NUM - 1 last
+    uint8_t boost;      // woke from I/O and has not used up a tick since
+    struct process_contrl_block* run_next;  // run queue links
+    struct process_contrl_block* run_prev;
+    uint8_t run_level;  // run queue it is on, SCHED_PRIO_NUM if none
+    uint32_t start_tick;    // pit tick the program started at
+    uint32_t run_ticks;     // pit ticks it was running at
+    uint32_t run_cnt;       // times it was switched to
+    uint32_t nvcsw;         // switched out when it blocked or exited
+    uint32_t nivcsw;        // switched out while still runnable
+    uint32_t last_tick;     // pit tick it was last switched to at
+    uint32_t wait_cycles;   // cycles spent in the run queue
+    uint32_t enqueue_tsc;   // when it last entered the run queue
+    struct wait_queue* wait_q;  // queue it sleeps on, NULL if none
+    struct process_contrl_block* wait_next;
+    struct ring* ring;  // user address of the syscall ring, NULL if none
     
     // Store signal handling information
     sighand_t handler; // a descriptor for all the signals
@@ -280,6 +329,8 @@ file_op_table_t  file_op_table;
 file_op_table_t  rtc_op_table;
 file_op_table_t  stdin_op_table;
 file_op_table_t  stdout_op_table;
+file_op_table_t  pseudo_op_table;
+file_op_table_t  pipe_op_table;
 
 /* Sets runtime-settable parameters in the GDT entry for the LDT */
 #define SET_LDT_PARAMS(str, addr, lim)                          \
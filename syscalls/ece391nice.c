@@ -0,0 +1,26 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 1024
+
+/* nice <priority> <command>: run a command at a priority from 0 (first)
+ * to 3 (last), e.g. "nice 3 counter" for a background cpu hog. */
+int main ()
+{
+    uint8_t buf[BUFSIZE];
+    int32_t prio;
+
+    if (0 != ece391_getargs (buf, BUFSIZE) ||
+        buf[0] < '0' || buf[0] > '9' || buf[1] != ' ') {
+        ece391_fdputs (1, (uint8_t*)"usage: nice <priority> <command>\n");
+        return 3;
+    }
+    prio = buf[0] - '0';
+    if (-1 == ece391_setpriority (-1, prio)) {
+        ece391_fdputs (1, (uint8_t*)"bad priority\n");
+        return 3;
+    }
+    return ece391_execute (buf + 2);
+}
@@ -0,0 +1,51 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define ROUNDS 10000
+#define BUFSIZE 16
+
+static uint32_t rdtsc_low (void)
+{
+    uint32_t low;
+    asm volatile ("rdtsc" : "=a"(low) : : "edx");
+    return low;
+}
+
+/* Time a call that does no work, read from fd -1, through the entry path
+ * currently selected. */
+static uint32_t null_call_cycles (void)
+{
+    uint32_t start;
+    int32_t i;
+
+    start = rdtsc_low ();
+    for (i = 0; i < ROUNDS; i++)
+        ece391_read (-1, 0, 0);
+    return (rdtsc_low () - start) / ROUNDS;
+}
+
+static void report (const uint8_t* path, uint32_t cycles)
+{
+    uint8_t buf[BUFSIZE];
+
+    ece391_fdputs (1, path);
+    ece391_fdputs (1, ece391_itoa (cycles, buf, 10));
+    ece391_fdputs (1, (uint8_t*)" cycles/call\n");
+}
+
+int main ()
+{
+    int32_t fast = ece391_use_sysenter;
+
+    ece391_use_sysenter = 0;
+    report ((uint8_t*)"int $0x80: ", null_call_cycles ());
+    if (!fast) {
+        ece391_fdputs (1, (uint8_t*)"sysenter: not supported\n");
+        return 0;
+    }
+    ece391_use_sysenter = fast;
+    report ((uint8_t*)"sysenter: ", null_call_cycles ());
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define TOTAL (100 * 1024 * 1024)
+#define CHUNK 4096
+#define NUMSIZE 16
+#define MCYCLE_SHIFT 20
+
+static uint8_t data[CHUNK];
+
+/* The time-stamp counter in units of 2^20 cycles, which a 100MB transfer
+ * does not overflow and which needs no 64-bit division. */
+static uint32_t rdtsc_mcycles (void)
+{
+    uint32_t low, high;
+    asm volatile ("rdtsc" : "=a"(low), "=d"(high));
+    return (high << (32 - MCYCLE_SHIFT)) | (low >> MCYCLE_SHIFT);
+}
+
+static void put_num (uint32_t value)
+{
+    uint8_t num[NUMSIZE];
+    ece391_fdputs (1, ece391_itoa (value, num, 10));
+}
+
+/* Fork a writer that pushes 100MB through a pipe in 4KB writes while this
+ * process reads it, then print the time and throughput. */
+int main ()
+{
+    int32_t fds[2], cnt, pid;
+    uint32_t start, total = 0, sent, mcycles;
+
+    if (-1 == ece391_pipe (fds)) {
+        ece391_fdputs (1, (uint8_t*)"pipe failed\n");
+        return 2;
+    }
+    start = rdtsc_mcycles ();
+    if (-1 == (pid = ece391_fork ())) {
+        ece391_fdputs (1, (uint8_t*)"fork failed\n");
+        return 2;
+    }
+    if (0 == pid) {
+        ece391_close (fds[0]);
+        for (sent = 0; sent < TOTAL; sent += CHUNK) {
+            if (CHUNK != ece391_write (fds[1], data, CHUNK))
+                return 3;
+        }
+        return 0;
+    }
+    ece391_close (fds[1]);
+    while (0 < (cnt = ece391_read (fds[0], data, CHUNK)))
+        total += cnt;
+    ece391_close (fds[0]);
+    mcycles = rdtsc_mcycles () - start;
+
+    put_num (total);
+    ece391_fdputs (1, (uint8_t*)" bytes in ");
+    put_num (mcycles);
+    ece391_fdputs (1, (uint8_t*)" Mcycles, ");
+    put_num (mcycles ? (total >> 10) / mcycles : 0);
+    ece391_fdputs (1, (uint8_t*)" KB/Mcycle\n");
+    return total == TOTAL ? 0 : 3;
+}
@@ -0,0 +1,30 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 1024
+
+/* quantum <ticks>: set the scheduler time slice to a number of 10ms pit
+ * ticks by writing it to the sched file. "cat sched" shows it. */
+int main ()
+{
+    int32_t fd;
+    uint8_t buf[BUFSIZE];
+
+    if (0 != ece391_getargs (buf, BUFSIZE)) {
+        ece391_fdputs (1, (uint8_t*)"usage: quantum <ticks>\n");
+        return 3;
+    }
+    if (-1 == (fd = ece391_open ((uint8_t*)"sched"))) {
+        ece391_fdputs (1, (uint8_t*)"sched file not found\n");
+        return 2;
+    }
+    if (-1 == ece391_write (fd, buf, ece391_strlen (buf))) {
+        ece391_fdputs (1, (uint8_t*)"quantum must be 1 to 100 ticks\n");
+        ece391_close (fd);
+        return 3;
+    }
+    ece391_close (fd);
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define CHUNK 1024
+#define BATCH 16
+#define BUFSIZE 1024
+#define NUMSIZE 16
+
+static uint8_t data[CHUNK];
+
+static uint32_t rdtsc_low (void)
+{
+    uint32_t low;
+    asm volatile ("rdtsc" : "=a"(low) : : "edx");
+    return low;
+}
+
+static void report (const uint8_t* path, uint32_t cycles, uint32_t traps)
+{
+    uint8_t num[NUMSIZE];
+
+    ece391_fdputs (1, path);
+    ece391_fdputs (1, ece391_itoa (cycles, num, 10));
+    ece391_fdputs (1, (uint8_t*)" cycles, ");
+    ece391_fdputs (1, ece391_itoa (traps, num, 10));
+    ece391_fdputs (1, (uint8_t*)" traps\n");
+}
+
+/* Read the whole file one trap per chunk, like cat does. */
+static int32_t read_traps (uint8_t* fname)
+{
+    uint32_t start, traps = 2;
+    int32_t fd, cnt;
+
+    start = rdtsc_low ();
+    if (-1 == (fd = ece391_open (fname)))
+        return -1;
+    while (0 < (cnt = ece391_read (fd, data, CHUNK)))
+        traps++;
+    ece391_close (fd);
+    report ((uint8_t*)"read:  ", rdtsc_low () - start, traps + 1);
+    return 0;
+}
+
+static void queue (ece391_ring_t* ring, int32_t op, int32_t fd, uint32_t buf, int32_t nbytes)
+{
+    ece391_sqe_t* sqe = &ring->sq[ring->sq_tail & RING_MASK];
+
+    sqe->op = op;
+    sqe->fd = fd;
+    sqe->buf = buf;
+    sqe->nbytes = nbytes;
+    sqe->user_data = ring->sq_tail;
+    ring->sq_tail++;
+}
+
+/* Read the whole file BATCH chunks per trap through the ring. */
+static int32_t read_ring (uint8_t* fname)
+{
+    ece391_ring_t* ring;
+    uint32_t start, traps = 1;
+    int32_t fd, res, i, done = 0;
+
+    start = rdtsc_low ();
+    if (-1 == ece391_ring_setup (&ring))
+        return -1;
+    queue (ring, RING_OP_OPEN, 0, (uint32_t)fname, 0);
+    ece391_ring_enter ();
+    traps++;
+    fd = ring->cq[ring->cq_head & RING_MASK].res;
+    ring->cq_head++;
+    if (-1 == fd)
+        return -1;
+    while (!done) {
+        for (i = 0; i < BATCH; i++)
+            queue (ring, RING_OP_READ, fd, (uint32_t)data, CHUNK);
+        ece391_ring_enter ();
+        traps++;
+        while (ring->cq_head != ring->cq_tail) {
+            res = ring->cq[ring->cq_head & RING_MASK].res;
+            if (res <= 0)
+                done = 1;
+            ring->cq_head++;
+        }
+    }
+    queue (ring, RING_OP_CLOSE, fd, 0, 0);
+    ece391_ring_enter ();
+    ring->cq_head++;
+    traps++;
+    report ((uint8_t*)"ring:  ", rdtsc_low () - start, traps);
+    return 0;
+}
+
+/* ringbench [file]: read a file to the end one trap per 1KB chunk, then
+ * through the syscall ring 16 chunks per trap, and print the cycles and
+ * traps each took. The data is not printed, so the terminal does not
+ * drown the difference. */
+int main ()
+{
+    uint8_t fname[BUFSIZE];
+
+    if (0 != ece391_getargs (fname, BUFSIZE))
+        ece391_strcpy (fname, (uint8_t*)"verylargetextwithverylongname.tx");
+    if (-1 == read_traps (fname) || -1 == read_ring (fname)) {
+        ece391_fdputs (1, (uint8_t*)"file not found\n");
+        return 2;
+    }
+    return 0;
+}
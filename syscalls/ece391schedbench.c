@@ -0,0 +1,47 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define COUNTERS 3
+#define SPIN_LOOPS 0x40000000
+#define RTC_RATE 2
+#define WAIT_READS 8        /* 4 seconds at 2 Hz */
+#define BUFSIZE 1024
+
+/* Start three cpu bound counters next to the idle shells, let them run for a
+ * few seconds and print the sched file: each counter should get about a
+ * third of the cpu and the shells next to none. */
+int main ()
+{
+    volatile uint32_t count = 0;
+    int32_t i, cnt, fd, rate;
+    uint8_t buf[BUFSIZE];
+
+    for (i = 0; i < COUNTERS; i++) {
+        if (ece391_fork() == 0) {
+            while (count < SPIN_LOOPS) count++;
+            return 0;
+        }
+    }
+
+    if (-1 == (fd = ece391_open((uint8_t*)"rtc"))) {
+        ece391_fdputs(1, (uint8_t*)"rtc open failed\n");
+        return 2;
+    }
+    rate = RTC_RATE;
+    ece391_write(fd, &rate, 4);
+    for (i = 0; i < WAIT_READS; i++) ece391_read(fd, &rate, 4);
+    ece391_close(fd);
+
+    if (-1 == (fd = ece391_open((uint8_t*)"sched"))) {
+        ece391_fdputs(1, (uint8_t*)"sched file not found\n");
+        return 2;
+    }
+    while (0 < (cnt = ece391_read(fd, buf, BUFSIZE - 1))) {
+        buf[cnt] = '\0';
+        ece391_fdputs(1, buf);
+    }
+    ece391_close(fd);
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define SPIN_LOOPS 0x01000000
+#define RTC_RATE 2
+#define WAIT_READS 8        /* 4 seconds at 2 Hz */
+#define BUFSIZE 1024
+
+/* Fork until no process can be created, let every child spin for a few
+ * seconds and print the sched file: cycles/tick and cycles/switch should
+ * stay flat however many processes are runnable. */
+int main ()
+{
+    volatile uint32_t count = 0;
+    int32_t cnt, fd, rate, pid;
+    uint32_t forked = 0;
+    uint8_t buf[BUFSIZE];
+
+    while (-1 != (pid = ece391_fork())) {
+        if (pid == 0) {
+            while (count < SPIN_LOOPS) count++;
+            return 0;
+        }
+        forked++;
+    }
+    ece391_fdputs(1, (uint8_t*)"forked ");
+    ece391_fdputs(1, ece391_itoa(forked, buf, 10));
+    ece391_fdputs(1, (uint8_t*)" processes\n");
+
+    if (-1 == (fd = ece391_open((uint8_t*)"rtc"))) {
+        ece391_fdputs(1, (uint8_t*)"rtc open failed\n");
+        return 2;
+    }
+    rate = RTC_RATE;
+    ece391_write(fd, &rate, 4);
+    for (cnt = 0; cnt < WAIT_READS; cnt++) ece391_read(fd, &rate, 4);
+    ece391_close(fd);
+
+    if (-1 == (fd = ece391_open((uint8_t*)"sched"))) {
+        ece391_fdputs(1, (uint8_t*)"sched file not found\n");
+        return 2;
+    }
+    while (0 < (cnt = ece391_read(fd, buf, BUFSIZE - 1))) {
+        buf[cnt] = '\0';
+        ece391_fdputs(1, buf);
+    }
+    ece391_close(fd);
+    return 0;
+}
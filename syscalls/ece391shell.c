@@ -4,10 +4,42 @@
 #include "ece391syscall.h"
 
 #define BUFSIZE 1024
+#define SAVED_STDIN 7
+
+/* Run "left | right": left in a forked shell with its stdout on a pipe,
+ * right here with its stdin on the other end. Returns right's status. */
+static int32_t
+run_pipe (uint8_t* left, uint8_t* right)
+{
+    int32_t fds[2], pid, rval;
+
+    if (-1 == ece391_pipe (fds))
+	return 2;
+    if (-1 == (pid = ece391_fork ())) {
+	ece391_close (fds[0]);
+	ece391_close (fds[1]);
+	return 2;
+    }
+    if (0 == pid) {
+	ece391_dup2 (fds[1], 1);
+	ece391_close (fds[0]);
+	ece391_close (fds[1]);
+	ece391_halt ((uint8_t)ece391_execute (left));
+    }
+    /* right sees the end of the data once left's copies are closed */
+    ece391_close (fds[1]);
+    ece391_dup2 (0, SAVED_STDIN);
+    ece391_dup2 (fds[0], 0);
+    ece391_close (fds[0]);
+    rval = ece391_execute (right);
+    ece391_dup2 (SAVED_STDIN, 0);
+    ece391_close (SAVED_STDIN);
+    return rval;
+}
 
 int main ()
 {
-    int32_t cnt, rval;
+    int32_t cnt, rval, bar;
     uint8_t buf[BUFSIZE];
     ece391_fdputs (1, (uint8_t*)"Starting 391 Shell\n");
 
@@ -24,7 +56,16 @@ int main ()
 	    return 0;
 	if ('\0' == buf[0])
 	    continue;
-	rval = ece391_execute (buf);
+	for (bar = 0; '\0' != buf[bar] && '|' != buf[bar]; bar++);
+	if ('|' == buf[bar]) {
+	    buf[bar] = '\0';
+	    /* execute would take trailing spaces as part of the arguments */
+	    for (cnt = bar - 1; cnt >= 0 && ' ' == buf[cnt]; cnt--)
+		buf[cnt] = '\0';
+	    rval = run_pipe (buf, buf + bar + 1);
+	} else {
+	    rval = ece391_execute (buf);
+	}
 	if (-1 == rval)
 	    ece391_fdputs (1, (uint8_t*)"no such command\n");
 	else if (256 == rval)
@@ -21,6 +21,87 @@ extern int32_t ece391_getargs (uint8_t* buf, int32_t nbytes);
 extern int32_t ece391_vidmap (uint8_t** screen_start);
 extern int32_t ece391_set_handler (int32_t signum, void* handler);
 extern int32_t ece391_sigreturn (void);
+/* Returns the child pid in the parent and 0 in the child; both keep running. */
+extern int32_t ece391_fork (void);
+/* pid -1 is the caller; 0 is the highest priority, 3 the lowest. */
+extern int32_t ece391_setpriority (int32_t pid, int32_t priority);
+
+/*
+ * Batched calls: ece391_ring_setup maps a page shared with the kernel.
+ * Queue entries in sq[sq_tail % RING_ENTRIES] and advance sq_tail; one
+ * ece391_ring_enter runs them all in order, leaving a completion for each
+ * in cq[cq_tail % RING_ENTRIES]. Advance cq_head once a completion is
+ * read. ring_enter returns how many entries it ran.
+ */
+#define RING_ENTRIES 64
+#define RING_MASK (RING_ENTRIES - 1)
+#define RING_OP_READ 1
+#define RING_OP_WRITE 2
+#define RING_OP_OPEN 3 /* buf is the file name */
+#define RING_OP_CLOSE 4
+
+typedef struct ece391_sqe {
+	int32_t op;
+	int32_t fd;
+	uint32_t buf;
+	int32_t nbytes;
+	uint32_t user_data;
+} ece391_sqe_t;
+
+typedef struct ece391_cqe {
+	int32_t res;
+	uint32_t user_data;
+} ece391_cqe_t;
+
+typedef struct ece391_ring {
+	volatile uint32_t sq_head;
+	volatile uint32_t sq_tail;
+	volatile uint32_t cq_head;
+	volatile uint32_t cq_tail;
+	ece391_sqe_t sq[RING_ENTRIES];
+	ece391_cqe_t cq[RING_ENTRIES];
+} ece391_ring_t;
+
+extern int32_t ece391_ring_setup (ece391_ring_t** ring);
+extern int32_t ece391_ring_enter (void);
+
+/* Move several buffers in one call; at most 16 buffers. readv stops after
+   a short read. Both return the total number of bytes. */
+typedef struct ece391_iovec {
+	void* base;
+	int32_t len;
+} ece391_iovec_t;
+
+extern int32_t ece391_readv (int32_t fd, const ece391_iovec_t* iov, int32_t iovcnt);
+extern int32_t ece391_writev (int32_t fd, const ece391_iovec_t* iov, int32_t iovcnt);
+
+/* fds[0] is the read end, fds[1] the write end. Reads return 0 once every
+   write end is closed; writes fail once every read end is closed. */
+extern int32_t ece391_pipe (int32_t fds[2]);
+/* Programs started with execute inherit fds 0 and 1. */
+extern int32_t ece391_dup2 (int32_t oldfd, int32_t newfd);
+
+#define ECE391_POLLIN   0x01
+#define ECE391_POLLOUT  0x04
+#define ECE391_POLLERR  0x08	/* revents only: pipe has no readers */
+#define ECE391_POLLHUP  0x10	/* revents only: pipe has no writers */
+#define ECE391_POLLNVAL 0x20	/* revents only: fd is not open */
+
+typedef struct ece391_pollfd {
+	int32_t fd;
+	int16_t events;
+	int16_t revents;
+} ece391_pollfd_t;
+
+/* Wait up to timeout ms (-1 for ever, 0 to only check) until one of the
+   fds is ready; returns how many have revents set. The terminal is
+   readable once a line is entered, the RTC once its rate's interrupt
+   came since the last read. */
+extern int32_t ece391_poll (ece391_pollfd_t* fds, int32_t nfds, int32_t timeout);
+
+/* Nonzero when the calls above use SYSENTER instead of int $0x80; set at
+   start up from CPUID, cleared to force int $0x80. */
+extern int32_t ece391_use_sysenter;
 
 enum signums {
 	DIV_ZERO = 0,
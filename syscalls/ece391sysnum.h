@@ -11,5 +11,14 @@
 #define SYS_VIDMAP  8
 #define SYS_SET_HANDLER  9
 #define SYS_SIGRETURN  10
+#define SYS_FORK    11
+#define SYS_SETPRIORITY 12
+#define SYS_RING_SETUP 13
+#define SYS_RING_ENTER 14
+#define SYS_READV   15
+#define SYS_WRITEV  16
+#define SYS_PIPE    17
+#define SYS_DUP2    18
+#define SYS_POLL    19
 
 #endif /* ECE391SYSNUM_H */
@@ -0,0 +1,55 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define RTC_RATE 2
+#define BUFSIZE 128
+#define NUMSIZE 16
+
+/* Wait on the keyboard and the RTC in one loop: count RTC ticks while
+ * idle and echo each line typed with the count so far. An empty line
+ * quits. */
+int main ()
+{
+    ece391_pollfd_t fds[2];
+    uint8_t buf[BUFSIZE + 1];
+    uint8_t num[NUMSIZE];
+    int32_t rtc_fd, cnt, garbage;
+    int32_t rate = RTC_RATE;
+    uint32_t ticks = 0;
+
+    if (-1 == (rtc_fd = ece391_open ((uint8_t*)"rtc"))) {
+        ece391_fdputs (1, (uint8_t*)"rtc open failed\n");
+        return 2;
+    }
+    ece391_write (rtc_fd, &rate, 4);
+    fds[0].fd = 0;
+    fds[0].events = ECE391_POLLIN;
+    fds[1].fd = rtc_fd;
+    fds[1].events = ECE391_POLLIN;
+
+    ece391_fdputs (1, (uint8_t*)"type a line, an empty one quits\n");
+    while (1) {
+        if (-1 == ece391_poll (fds, 2, -1)) {
+            ece391_fdputs (1, (uint8_t*)"poll failed\n");
+            return 3;
+        }
+        if (fds[1].revents & ECE391_POLLIN) {
+            ece391_read (rtc_fd, &garbage, 4);
+            ticks++;
+        }
+        if (fds[0].revents & ECE391_POLLIN) {
+            cnt = ece391_read (0, buf, BUFSIZE);
+            // only the newline, or the end of a pipe
+            if (cnt <= 1)
+                break;
+            buf[cnt] = '\0';
+            ece391_fdputs (1, ece391_itoa (ticks, num, 10));
+            ece391_fdputs (1, (uint8_t*)" ticks: ");
+            ece391_fdputs (1, buf);
+        }
+    }
+    ece391_close (rtc_fd);
+    return 0;
+}